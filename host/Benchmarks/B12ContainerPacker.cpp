@@ -0,0 +1,133 @@
+/*
+   ==============================================================================
+
+   Packs plain b12 files into a b12 container (see B12Container.hpp). Given a
+   left and right pair, such as the LOOP1L.B12 and LOOP1R.B12 the engine would
+   otherwise load as two tracks, it writes a single interleaved stereo file that
+   streams and decodes as one track. Given a single file, it writes a mono
+   container, which is only useful to record a sample rate other than
+   MNEMONIC_SAMPLE_RATE so the engine resamples it. The b12 data is copied as
+   is, a chunk at a time, so nothing is decoded or re-encoded. A pair of files
+   of different lengths is cut to the shorter one.
+
+   Once written, the output is read back and its header and every chunk are
+   checked against the inputs, so a container the engine can't play is never
+   left behind silently.
+
+   usage: B12ContainerPacker <output b12> <sample rate in Hz> <left or mono b12> [right b12]
+
+   ==============================================================================
+   */
+
+#include "B12Container.hpp"
+#include "B12DecodeMix.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+constexpr unsigned int CHUNK_SIZE_IN_BYTES = ( B12_DECODE_MIX_CHUNK_SIZE * 3 ) / 2;
+
+static bool readFile (const char* filename, std::vector<uint8_t>& data)
+{
+	std::ifstream file( filename, std::ios::binary );
+	if ( ! file.is_open() ) return false;
+
+	data.assign( std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() );
+
+	return true;
+}
+
+int main (int argc, char* argv[])
+{
+	if ( argc < 4 )
+	{
+		std::printf( "usage: %s <output b12> <sample rate in Hz> <left or mono b12> [right b12]\n", argv[0] );
+		return 1;
+	}
+
+	const long sampleRate = std::atol( argv[2] );
+	if ( sampleRate <= 0 )
+	{
+		std::printf( "the sample rate must be a positive number of Hz, not %s\n", argv[2] );
+		return 1;
+	}
+
+	const unsigned int numChannels = ( argc > 4 ) ? 2 : 1;
+	std::vector<uint8_t> channels[2];
+	for ( unsigned int channel = 0; channel < numChannels; channel++ )
+	{
+		if ( ! readFile(argv[3 + channel], channels[channel]) )
+		{
+			std::printf( "couldn't read %s\n", argv[3 + channel] );
+			return 1;
+		}
+
+		B12ContainerHeader header;
+		if ( ! B12ReadContainerHeader(channels[channel].data(), channels[channel].size(), header) || header.m_HeaderSizeInBytes != 0 )
+		{
+			std::printf( "%s is already a container, only plain b12 files can be packed\n", argv[3 + channel] );
+			return 1;
+		}
+	}
+
+	// only whole chunks are packed, since a stereo container alternates channels every chunk
+	size_t numChunks = channels[0].size() / CHUNK_SIZE_IN_BYTES;
+	if ( numChannels == 2 && channels[1].size() / CHUNK_SIZE_IN_BYTES < numChunks ) numChunks = channels[1].size() / CHUNK_SIZE_IN_BYTES;
+	if ( numChunks == 0 )
+	{
+		std::printf( "nothing to pack, the input is shorter than a chunk of %u bytes\n", CHUNK_SIZE_IN_BYTES );
+		return 1;
+	}
+
+	std::vector<uint8_t> container( B12_CONTAINER_HEADER_SIZE + (numChunks * CHUNK_SIZE_IN_BYTES * numChannels) );
+	B12WriteContainerHeader( container.data(), numChannels, static_cast<unsigned int>(sampleRate) );
+	for ( size_t chunk = 0; chunk < numChunks; chunk++ )
+	{
+		for ( unsigned int channel = 0; channel < numChannels; channel++ )
+		{
+			std::memcpy( &container[B12_CONTAINER_HEADER_SIZE + ((chunk * numChannels) + channel) * CHUNK_SIZE_IN_BYTES],
+					&channels[channel][chunk * CHUNK_SIZE_IN_BYTES], CHUNK_SIZE_IN_BYTES );
+		}
+	}
+
+	{
+		std::ofstream file( argv[1], std::ios::binary );
+		if ( ! file.is_open() || ! file.write(reinterpret_cast<const char*>(container.data()), container.size()) )
+		{
+			std::printf( "couldn't write %s\n", argv[1] );
+			return 1;
+		}
+	}
+
+	// read back what actually landed on disk, the same way the engine reads it
+	std::vector<uint8_t> written;
+	B12ContainerHeader header;
+	if ( ! readFile(argv[1], written) || ! B12ReadContainerHeader(written.data(), written.size(), header)
+		|| header.m_HeaderSizeInBytes != B12_CONTAINER_HEADER_SIZE || header.m_NumChannels != numChannels
+		|| header.m_SampleRate != static_cast<unsigned int>(sampleRate) || written.size() != container.size() )
+	{
+		std::printf( "%s didn't read back as a %u channel container at %ld Hz\n", argv[1], numChannels, sampleRate );
+		return 1;
+	}
+	for ( size_t chunk = 0; chunk < numChunks; chunk++ )
+	{
+		for ( unsigned int channel = 0; channel < numChannels; channel++ )
+		{
+			if ( std::memcmp(&written[header.m_HeaderSizeInBytes + ((chunk * numChannels) + channel) * CHUNK_SIZE_IN_BYTES],
+						&channels[channel][chunk * CHUNK_SIZE_IN_BYTES], CHUNK_SIZE_IN_BYTES) != 0 )
+			{
+				std::printf( "%s doesn't match the input at chunk %zu of channel %u\n", argv[1], chunk, channel );
+				return 1;
+			}
+		}
+	}
+
+	std::printf( "packed %zu chunks of %u channel%s at %ld Hz into %s\n", numChunks, numChannels, (numChannels == 2) ? "s" : "",
+			sampleRate, argv[1] );
+
+	return 0;
+}
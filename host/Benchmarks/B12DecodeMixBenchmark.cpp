@@ -0,0 +1,233 @@
+/*
+   ==============================================================================
+
+   A micro-benchmark for the b12 decode and mix kernel. It times the previous
+   whole block decode (B12Decompress into a shared buffer, then a float mix), the
+   scalar reference and the SIMD path picked for this build, and reports the
+   cost per track per audio block. The SIMD output is checked against the
+   scalar reference before anything is timed, as are the interleaved stereo
+   paths and the variants picked by B12SelectDecodeMix, one pair of pan gains
+   at a time. Resampling a 44.1 kHz track to the engine's rate, decode
+   included, is timed as AudioTrack does it. The master limiter, which runs
+   once per audio block on the summed mix bus, is timed last.
+
+   ==============================================================================
+   */
+
+#include "AudioConstants.hpp"
+#include "B12Compression.hpp"
+#include "B12DecodeMix.hpp"
+#include "MasterLimiter.hpp"
+#include "MnemonicConstants.hpp"
+#include "PolyphaseResampler.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+#include <x86intrin.h>
+#define BENCHMARK_HAS_TSC
+#endif
+
+constexpr unsigned int NUM_TRACKS = 16;
+constexpr unsigned int NUM_BLOCKS = 20000;
+constexpr unsigned int COMPRESSED_BLOCK_SIZE = ( ABUFFER_SIZE * 3 ) / 2;
+constexpr unsigned int COMPRESSED_CHUNK_SIZE = ( B12_DECODE_MIX_CHUNK_SIZE * 3 ) / 2;
+constexpr unsigned int RESAMPLED_SAMPLE_RATE = 44100;
+
+static uint8_t  compressedBlocks[NUM_TRACKS][COMPRESSED_BLOCK_SIZE];
+static uint16_t decompressedBuffer[ABUFFER_SIZE];
+static int32_t  busL[ABUFFER_SIZE];
+static int32_t  busR[ABUFFER_SIZE];
+static PolyphaseResampler resamplers[NUM_TRACKS];
+static unsigned int resamplerChunks[NUM_TRACKS]; // the next chunk of the track's compressed block to push, wrapping around
+
+static void wholeBlockDecodeMix (const uint8_t* compressed, unsigned int numSamples, int32_t* writeBufferL, int32_t* writeBufferR,
+				float amplitudeL, float amplitudeR)
+{
+	B12Decompress( compressed, ( numSamples * 3 ) / 2, decompressedBuffer, numSamples );
+
+	for ( unsigned int sample = 0; sample < numSamples; sample++ )
+	{
+		int16_t sampleVal = ( static_cast<int16_t>(decompressedBuffer[sample]) - (4096 / 2) ) / 2;
+		writeBufferL[sample] += sampleVal * amplitudeL;
+		writeBufferR[sample] += sampleVal * amplitudeR;
+	}
+}
+
+// runs one variant on freshly zeroed buses and compares it straight away, so one variant's error can't cancel out another's.
+// an interleaved stereo block spans the first two tracks' compressed blocks, and its reference decodes each channel's chunks
+// with the other bus silent
+static bool checkDecodeMix (const char* name, B12DecodeMixFunction decodeMix, bool interleavedStereo, int16_t gainL, int16_t gainR)
+{
+	int32_t referenceL[ABUFFER_SIZE] = { 0 };
+	int32_t referenceR[ABUFFER_SIZE] = { 0 };
+	std::memset( busL, 0, sizeof(busL) );
+	std::memset( busR, 0, sizeof(busR) );
+
+	decodeMix( compressedBlocks[0], ABUFFER_SIZE, busL, busR, gainL, gainR );
+	if ( interleavedStereo )
+	{
+		const uint8_t* compressed = compressedBlocks[0];
+		for ( unsigned int frame = 0; frame < ABUFFER_SIZE; frame += B12_DECODE_MIX_CHUNK_SIZE )
+		{
+			B12DecodeMixScalar( compressed, B12_DECODE_MIX_CHUNK_SIZE, &referenceL[frame], &referenceR[frame], gainL, 0 );
+			compressed += COMPRESSED_CHUNK_SIZE;
+			B12DecodeMixScalar( compressed, B12_DECODE_MIX_CHUNK_SIZE, &referenceL[frame], &referenceR[frame], 0, gainR );
+			compressed += COMPRESSED_CHUNK_SIZE;
+		}
+	}
+	else
+	{
+		B12DecodeMixScalar( compressedBlocks[0], ABUFFER_SIZE, referenceL, referenceR, gainL, gainR );
+	}
+
+	if ( std::memcmp(busL, referenceL, sizeof(busL)) != 0 || std::memcmp(busR, referenceR, sizeof(busR)) != 0 )
+	{
+		std::printf( "%s (%s) does not match B12DecodeMixScalar for gains (%d, %d)\n", name, (interleavedStereo) ? "stereo" : "mono",
+				gainL, gainR );
+		return false;
+	}
+
+	return true;
+}
+
+template <typename Kernel>
+static void runBenchmark (const char* name, Kernel kernel)
+{
+	const auto startTime = std::chrono::steady_clock::now();
+#ifdef BENCHMARK_HAS_TSC
+	const uint64_t startCycles = __rdtsc();
+#endif
+
+	for ( unsigned int block = 0; block < NUM_BLOCKS; block++ )
+	{
+		std::memset( busL, 0, sizeof(busL) );
+		std::memset( busR, 0, sizeof(busR) );
+
+		for ( unsigned int track = 0; track < NUM_TRACKS; track++ )
+		{
+			kernel( compressedBlocks[track] );
+		}
+	}
+
+#ifdef BENCHMARK_HAS_TSC
+	const uint64_t cycles = __rdtsc() - startCycles;
+#endif
+	const auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - startTime );
+
+	const double numTrackBlocks = static_cast<double>( NUM_TRACKS ) * NUM_BLOCKS;
+	std::printf( "%-12s %10.1f ns/track-block", name, nanoseconds.count() / numTrackBlocks );
+#ifdef BENCHMARK_HAS_TSC
+	std::printf( " %10.1f cycles/track-block", cycles / numTrackBlocks );
+#endif
+	std::printf( " (bus checksum %d)\n", busL[ABUFFER_SIZE / 2] + busR[ABUFFER_SIZE / 3] );
+}
+
+// decodes whole chunks into the resampler until it can produce a block, then mixes the block in
+static void resampleDecodeMix (unsigned int track, int32_t* writeBufferL, int32_t* writeBufferR, int16_t gainL, int16_t gainR)
+{
+	static const B12DecodeMixFunction decodeMix = B12SelectDecodeMix( B12_DECODE_MIX_UNITY_GAIN, 0, false );
+	PolyphaseResampler& resampler = resamplers[track];
+
+	while ( resampler.getSourceFramesNeeded(ABUFFER_SIZE) > 0 )
+	{
+		int32_t chunk[B12_DECODE_MIX_CHUNK_SIZE] = { 0 };
+		const unsigned int chunkIndex = resamplerChunks[track]++ % ( ABUFFER_SIZE / B12_DECODE_MIX_CHUNK_SIZE );
+		decodeMix( &compressedBlocks[track][chunkIndex * COMPRESSED_CHUNK_SIZE], B12_DECODE_MIX_CHUNK_SIZE, chunk, chunk,
+				B12_DECODE_MIX_UNITY_GAIN, 0 );
+		resampler.pushSourceFrames( chunk, nullptr, B12_DECODE_MIX_CHUNK_SIZE );
+	}
+
+	resampler.process( ABUFFER_SIZE, writeBufferL, writeBufferR, gainL, gainR );
+}
+
+static void runLimiterBenchmark()
+{
+	// a full mix bus from the last benchmark, loud enough to keep the limiter working
+	static int16_t writeBufferL[ABUFFER_SIZE];
+	static int16_t writeBufferR[ABUFFER_SIZE];
+	MasterLimiter limiter;
+
+	const auto startTime = std::chrono::steady_clock::now();
+#ifdef BENCHMARK_HAS_TSC
+	const uint64_t startCycles = __rdtsc();
+#endif
+
+	for ( unsigned int block = 0; block < NUM_BLOCKS; block++ )
+	{
+		std::memset( writeBufferL, 0, sizeof(writeBufferL) );
+		std::memset( writeBufferR, 0, sizeof(writeBufferR) );
+
+		limiter.process( busL, busR, writeBufferL, writeBufferR );
+	}
+
+#ifdef BENCHMARK_HAS_TSC
+	const uint64_t cycles = __rdtsc() - startCycles;
+#endif
+	const auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - startTime );
+
+	std::printf( "%-12s %10.1f ns/block      ", "limiter", nanoseconds.count() / static_cast<double>(NUM_BLOCKS) );
+#ifdef BENCHMARK_HAS_TSC
+	std::printf( " %10.1f cycles/block      ", cycles / static_cast<double>(NUM_BLOCKS) );
+#endif
+	std::printf( " (gain %d)\n", limiter.getGain() );
+}
+
+int main()
+{
+	std::mt19937 random( 0 );
+	for ( unsigned int track = 0; track < NUM_TRACKS; track++ )
+	{
+		for ( unsigned int byte = 0; byte < COMPRESSED_BLOCK_SIZE; byte++ )
+		{
+			compressedBlocks[track][byte] = static_cast<uint8_t>( random() );
+		}
+	}
+
+	// make sure every SIMD path is exact before timing it
+	const int16_t gains[] = { B12_DECODE_MIX_UNITY_GAIN, 0, B12GainFromAmplitude(0.3f), B12GainFromAmplitude(-1.5f), 32767, -32768 };
+	for ( const int16_t gainL : gains )
+	{
+		for ( const int16_t gainR : gains )
+		{
+			if ( ! checkDecodeMix("B12DecodeMix", B12DecodeMix, false, gainL, gainR)
+				|| ! checkDecodeMix("B12SelectDecodeMix", B12SelectDecodeMix(gainL, gainR, false), false, gainL, gainR)
+				|| ! checkDecodeMix("B12DecodeMixStereo", B12DecodeMixStereo, true, gainL, gainR)
+				|| ! checkDecodeMix("B12SelectDecodeMix", B12SelectDecodeMix(gainL, gainR, true), true, gainL, gainR) )
+			{
+				return 1;
+			}
+		}
+	}
+
+	std::printf( "%u tracks, %u blocks of %u samples\n", NUM_TRACKS, NUM_BLOCKS, ABUFFER_SIZE );
+
+	runBenchmark( "whole block", [](const uint8_t* compressed) {
+			wholeBlockDecodeMix( compressed, ABUFFER_SIZE, busL, busR, 1.0f, 0.5f ); } );
+	runBenchmark( "scalar", [](const uint8_t* compressed) {
+			B12DecodeMixScalar( compressed, ABUFFER_SIZE, busL, busR, B12_DECODE_MIX_UNITY_GAIN, B12GainFromAmplitude(0.5f) ); } );
+	runBenchmark( "simd", [](const uint8_t* compressed) {
+			B12DecodeMix( compressed, ABUFFER_SIZE, busL, busR, B12_DECODE_MIX_UNITY_GAIN, B12GainFromAmplitude(0.5f) ); } );
+	runBenchmark( "simd (1,0)", [](const uint8_t* compressed) {
+			static const B12DecodeMixFunction decodeMix = B12SelectDecodeMix( B12_DECODE_MIX_UNITY_GAIN, 0, false );
+			decodeMix( compressed, ABUFFER_SIZE, busL, busR, B12_DECODE_MIX_UNITY_GAIN, 0 ); } );
+	runBenchmark( "simd (1,1)", [](const uint8_t* compressed) {
+			static const B12DecodeMixFunction decodeMix = B12SelectDecodeMix( B12_DECODE_MIX_UNITY_GAIN,
+												B12_DECODE_MIX_UNITY_GAIN, false );
+			decodeMix( compressed, ABUFFER_SIZE, busL, busR, B12_DECODE_MIX_UNITY_GAIN, B12_DECODE_MIX_UNITY_GAIN ); } );
+
+	for ( unsigned int track = 0; track < NUM_TRACKS; track++ )
+	{
+		resamplers[track].configure( RESAMPLED_SAMPLE_RATE, MNEMONIC_SAMPLE_RATE, 1, ABUFFER_SIZE, B12_DECODE_MIX_CHUNK_SIZE );
+	}
+	runBenchmark( "resample", [](const uint8_t* compressed) {
+			const unsigned int track = ( compressed - compressedBlocks[0] ) / COMPRESSED_BLOCK_SIZE;
+			resampleDecodeMix( track, busL, busR, B12_DECODE_MIX_UNITY_GAIN, B12GainFromAmplitude(0.5f) ); } );
+
+	runLimiterBenchmark();
+
+	return 0;
+}
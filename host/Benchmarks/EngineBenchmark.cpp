@@ -0,0 +1,218 @@
+/*
+   ==============================================================================
+
+   A headless benchmark for the whole audio engine. It loads a scene from an
+   sd card image through the same parameter events the ui sends, then drives
+   MnemonicAudioManager::call as fast as possible. Cells are only ever played
+   through PLAY_OR_STOP_TRACK events, so the engine runs exactly the mixes the
+   ui can reach. Only one cell plays per lane, and the second loop lane and the
+   one-shot lane stop each other. Each run adds one more cell to the mix,
+   taking the first loaded cell of each lane in turn: the first audio loop
+   lane, the second audio loop lane (or the one-shot lane if it has nothing
+   loaded), then each midi loop lane. A one-shot is played again whenever it
+   finishes. Each run reports blocks per second and per-block latency
+   percentiles against the block deadline, named by the number of tracks
+   playing, where each audio channel streamed from its own file is a track.
+   The last line is the highest track count whose p99.9 fits in the deadline.
+
+   Audio tracks stream through blocking reads of the image here, so the cost
+   of the sd card reads is part of each block rather than hidden by a worker
+   thread that can't keep up with a faster than real time clock.
+
+   usage: EngineBenchmark <sd card image> <scene name, such as SCENE1.SCN> [seconds per run]
+
+   ==============================================================================
+   */
+
+#include "AudioConstants.hpp"
+#include "CPPFile.hpp"
+#include "MnemonicAudioManager.hpp"
+#include "MnemonicConstants.hpp"
+#include "SceneLoader.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+constexpr double DEFAULT_SECONDS_PER_RUN = 5.0;
+constexpr unsigned int AXI_SRAM_SIZE = 524288; // 512kB, as on the target
+
+static uint8_t axiSram[AXI_SRAM_SIZE];
+static int16_t writeBufferL[ABUFFER_SIZE];
+static int16_t writeBufferR[ABUFFER_SIZE];
+
+// drives the engine for the given time, playing any of the playing cells that finish again, returns the 99.9th percentile block
+// latency in nanoseconds
+static double runEngine (MnemonicAudioManager& audioManager, SceneLoaderUiListener& uiListener,
+				const std::vector<SceneLoaderUiListener::Cell>& playingCells, const char* name, double seconds)
+{
+	const double deadlineInNanoseconds = ( 1e9 * ABUFFER_SIZE ) / MNEMONIC_SAMPLE_RATE;
+	std::vector<double> blockLatencies;
+
+	const auto startTime = std::chrono::steady_clock::now();
+	const auto endTime = startTime + std::chrono::duration<double>( seconds );
+	auto now = startTime;
+	while ( now < endTime )
+	{
+		std::memset( writeBufferL, 0, sizeof(writeBufferL) );
+		std::memset( writeBufferR, 0, sizeof(writeBufferR) );
+
+		audioManager.call( writeBufferL, writeBufferR );
+
+		const auto blockEnd = std::chrono::steady_clock::now();
+		blockLatencies.push_back( std::chrono::duration<double, std::nano>(blockEnd - now).count() );
+		now = blockEnd;
+
+		// the periodic work the main loop does between blocks, not timed
+		audioManager.getMidiEventsToSend().clear();
+		uiListener.m_FinishedCells.clear();
+		audioManager.publishUiEvents();
+		const std::vector<SceneLoaderUiListener::Cell> finishedCells = uiListener.m_FinishedCells; // playing again adds to it
+		for ( const SceneLoaderUiListener::Cell& finishedCell : finishedCells )
+		{
+			for ( const SceneLoaderUiListener::Cell& cell : playingCells )
+			{
+				if ( cell.m_CellX == finishedCell.m_CellX && cell.m_CellY == finishedCell.m_CellY )
+				{
+					PlayOrStopCell( cell.m_CellX, cell.m_CellY, true );
+				}
+			}
+		}
+		now = std::chrono::steady_clock::now();
+	}
+
+	const double elapsedSeconds = std::chrono::duration<double>( now - startTime ).count();
+	std::sort( blockLatencies.begin(), blockLatencies.end() );
+	auto percentile = [&blockLatencies](double fraction) {
+			return blockLatencies[static_cast<size_t>( fraction * (blockLatencies.size() - 1) )]; };
+
+	const double p999 = percentile( 0.999 );
+	std::printf( "%-12s %10.0f %10.0f %10.0f %10.0f %10.0f %10.0f %9.1f%% %10u\n", name,
+			blockLatencies.size() / elapsedSeconds, percentile(0.5), percentile(0.9), percentile(0.99), p999,
+			blockLatencies.back(), (p999 * 100.0) / deadlineInNanoseconds, uiListener.m_NumUnderruns );
+
+	return p999;
+}
+
+// the first cell loaded on a row, returns false if none is
+static bool findFirstCellOnRow (const SceneLoaderUiListener& uiListener, const MNEMONIC_ROW row, SceneLoaderUiListener::Cell& cell)
+{
+	for ( const SceneLoaderUiListener::Cell& loadedCell : uiListener.m_LoadedCells )
+	{
+		if ( loadedCell.m_CellY == static_cast<unsigned int>(row) )
+		{
+			cell = loadedCell;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// an audio cell plays one track per file it streams, a midi cell is a single track
+static unsigned int getNumTracks (const SceneLoaderUiListener& uiListener, const SceneLoaderUiListener::Cell& cell)
+{
+	if ( cell.m_CellY >= static_cast<unsigned int>(MNEMONIC_ROW::MIDI_CHAN_1_LOOPS) ) return 1;
+
+	unsigned int numTracks = 0;
+	for ( const SceneLoaderUiListener::Cell& trackCell : uiListener.m_AudioTrackCells )
+	{
+		if ( trackCell.m_CellX == cell.m_CellX && trackCell.m_CellY == cell.m_CellY ) numTracks++;
+	}
+
+	return numTracks;
+}
+
+int main (int argc, char* argv[])
+{
+	if ( argc < 3 )
+	{
+		std::printf( "usage: %s <sd card image> <scene name, such as SCENE1.SCN> [seconds per run]\n", argv[0] );
+		return 1;
+	}
+	const double secondsPerRun = ( argc > 3 ) ? std::atof( argv[3] ) : DEFAULT_SECONDS_PER_RUN;
+	if ( secondsPerRun <= 0.0 )
+	{
+		std::printf( "the seconds per run must be a positive number, not %s\n", argv[3] );
+		return 1;
+	}
+
+	CPPFile sdCard( argv[1] );
+	MnemonicAudioManager audioManager( sdCard, axiSram, sizeof(axiSram) );
+	audioManager.bindToMnemonicParameterEventSystem();
+
+	SceneLoaderUiListener uiListener;
+	uiListener.bindToMnemonicUiEventSystem();
+
+	audioManager.verifyFileSystem();
+	if ( ! LoadScene(uiListener, argv[2]) )
+	{
+		std::printf( "couldn't find scene %s\n", argv[2] );
+		return 1;
+	}
+
+	// the cells added to the mix one run at a time, the second audio lane is whichever of the lanes that stop each other has
+	// a cell, preferring the loop lane since a one-shot is silent between finishing and being played again
+	std::vector<SceneLoaderUiListener::Cell> cellsToAdd;
+	const MNEMONIC_ROW lanes[] = { MNEMONIC_ROW::AUDIO_LOOPS_1, MNEMONIC_ROW::AUDIO_LOOPS_2, MNEMONIC_ROW::MIDI_CHAN_1_LOOPS,
+					MNEMONIC_ROW::MIDI_CHAN_2_LOOPS, MNEMONIC_ROW::MIDI_CHAN_3_LOOPS, MNEMONIC_ROW::MIDI_CHAN_4_LOOPS };
+	for ( const MNEMONIC_ROW lane : lanes )
+	{
+		SceneLoaderUiListener::Cell cell;
+		if ( findFirstCellOnRow(uiListener, lane, cell)
+			|| (lane == MNEMONIC_ROW::AUDIO_LOOPS_2 && findFirstCellOnRow(uiListener, MNEMONIC_ROW::AUDIO_ONESHOTS, cell)) )
+		{
+			cellsToAdd.push_back( cell );
+		}
+	}
+	if ( cellsToAdd.empty() )
+	{
+		std::printf( "%s has no cells loaded on the audio or midi lanes\n", argv[2] );
+		return 1;
+	}
+
+	// nothing plays yet, this only lets the engine publish its stream telemetry so the tracks of each audio cell are known
+	for ( unsigned int block = 0; block <= MNEMONIC_STREAM_TELEMETRY_PERIOD_IN_BLOCKS; block++ )
+	{
+		audioManager.call( writeBufferL, writeBufferR );
+		audioManager.publishUiEvents();
+	}
+
+	std::printf( "%u cells loaded from %s, %u samples per block, deadline %.0f ns\n",
+			static_cast<unsigned int>(uiListener.m_LoadedCells.size()), argv[2], ABUFFER_SIZE,
+			(1e9 * ABUFFER_SIZE) / MNEMONIC_SAMPLE_RATE );
+	std::printf( "%-12s %10s %10s %10s %10s %10s %10s %10s %10s\n", "run", "blocks/s", "p50 ns", "p90 ns", "p99 ns", "p99.9 ns",
+			"max ns", "p99.9/dl", "underruns" ); // underruns are a running total
+
+	const double deadlineInNanoseconds = ( 1e9 * ABUFFER_SIZE ) / MNEMONIC_SAMPLE_RATE;
+	std::vector<SceneLoaderUiListener::Cell> playingCells;
+	unsigned int numTracks = 0;
+	unsigned int mostTracksInRealTime = 0;
+	for ( const SceneLoaderUiListener::Cell& cell : cellsToAdd )
+	{
+		PlayOrStopCell( cell.m_CellX, cell.m_CellY, true );
+		playingCells.push_back( cell );
+		numTracks += getNumTracks( uiListener, cell );
+
+		char name[32];
+		std::snprintf( name, sizeof(name), "%u track%s", numTracks, (numTracks == 1) ? "" : "s" );
+		if ( runEngine(audioManager, uiListener, playingCells, name, secondsPerRun) <= deadlineInNanoseconds )
+		{
+			mostTracksInRealTime = numTracks;
+		}
+	}
+
+	if ( mostTracksInRealTime > 0 )
+	{
+		std::printf( "the most tracks that sustain real time is %u\n", mostTracksInRealTime );
+	}
+	else
+	{
+		std::printf( "not even a single track sustains real time\n" );
+	}
+
+	return 0;
+}
@@ -0,0 +1,98 @@
+/*
+   ==============================================================================
+
+   Loads a scene into a MnemonicAudioManager the way the ui does, for the
+   engine tools that run without JUCE. The listener stands in for the ui,
+   picking the scene out of the file explorer and keeping track of what the
+   engine reports back.
+
+   ==============================================================================
+   */
+
+#pragma once
+
+#include "IMnemonicParameterEventListener.hpp"
+#include "IMnemonicUiEventListener.hpp"
+#include "MnemonicConstants.hpp"
+
+#include <strings.h>
+#include <vector>
+
+class SceneLoaderUiListener : public IMnemonicUiEventListener
+{
+	public:
+		struct Cell
+		{
+			unsigned int m_CellX;
+			unsigned int m_CellY;
+		};
+
+		std::vector<UiFileExplorerEntry> 	m_SceneEntries;
+		std::vector<Cell> 			m_LoadedCells;
+		std::vector<Cell> 			m_AudioTrackCells; // the cell of each loaded audio track, from the last telemetry
+		std::vector<Cell> 			m_FinishedCells; // audio cells that finished playing, for the owner to clear
+		unsigned int 				m_NumUnderruns = 0;
+
+		void onMnemonicUiEvent (const MnemonicUiEvent& event) override
+		{
+			switch ( event.getEventType() )
+			{
+				case UiEventType::ENTER_FILE_EXPLORER:
+				{
+					const UiFileExplorerEntry* entries = static_cast<const UiFileExplorerEntry*>( event.getDataPtr() );
+					m_SceneEntries.assign( entries, entries + event.getDataNumElements() );
+				}
+
+					break;
+				case UiEventType::SCENE_TRACK_FILE_LOADED:
+					m_LoadedCells.push_back( Cell{event.getCellX(), event.getCellY()} );
+
+					break;
+				case UiEventType::AUDIO_TRACK_FINISHED:
+					m_FinishedCells.push_back( Cell{event.getCellX(), event.getCellY()} );
+
+					break;
+				case UiEventType::STREAM_TELEMETRY:
+				{
+					const UiStreamTelemetry* telemetry = static_cast<const UiStreamTelemetry*>( event.getDataPtr() );
+					m_NumUnderruns = telemetry->m_NumUnderruns;
+					m_AudioTrackCells.clear();
+					for ( unsigned int track = 0; track < telemetry->m_NumTracks; track++ )
+					{
+						m_AudioTrackCells.push_back( Cell{telemetry->m_Tracks[track].m_CellX, telemetry->m_Tracks[track].m_CellY} );
+					}
+				}
+
+					break;
+				default:
+					break;
+			}
+		}
+};
+
+// the listener must already be bound to the ui event system, returns false if there is no scene with that name
+inline bool LoadScene (SceneLoaderUiListener& uiListener, const char* sceneName)
+{
+	// the manager answers with the scene directory listing, then loading a listed scene is a load on the transport row
+	IMnemonicParameterEventListener::PublishEvent( MnemonicParameterEvent(0, 0, 0, static_cast<unsigned int>(PARAM_CHANNEL::LOAD_SCENE)) );
+
+	for ( const UiFileExplorerEntry& entry : uiListener.m_SceneEntries )
+	{
+		if ( strcasecmp(entry.m_FilenameDisplay, sceneName) == 0 )
+		{
+			const unsigned int transportRow = static_cast<unsigned int>( MNEMONIC_ROW::TRANSPORT );
+			IMnemonicParameterEventListener::PublishEvent( MnemonicParameterEvent(0, transportRow, entry.m_Index,
+											static_cast<unsigned int>(PARAM_CHANNEL::LOAD_FILE)) );
+
+			return true;
+		}
+	}
+
+	return false;
+}
+
+inline void PlayOrStopCell (unsigned int cellX, unsigned int cellY, bool play)
+{
+	IMnemonicParameterEventListener::PublishEvent( MnemonicParameterEvent(cellX, cellY, play,
+									static_cast<unsigned int>(PARAM_CHANNEL::PLAY_OR_STOP_TRACK)) );
+}
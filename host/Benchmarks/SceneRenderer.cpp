@@ -0,0 +1,217 @@
+/*
+   ==============================================================================
+
+   An offline renderer for scenes. It loads a scene from an sd card image the
+   same way the ui does (see SceneLoader.hpp), plays and stops cells following
+   a timeline file, and writes what the master limiter outputs to a 16-bit
+   stereo wav file at MNEMONIC_SAMPLE_RATE, rendering as fast as the cpu
+   allows. Rendering the same scene and timeline twice gives the same file, so
+   the output can be diffed against a known good render.
+
+   The timeline is one event per line, times in seconds from the start of the
+   render, and lines starting with # are ignored:
+
+      0.0 play 0 1     (play the cell at x 0, y 1)
+      4.0 stop 0 1
+      8.0 end          (the length of the render)
+
+   Events happen at the start of the audio block they fall in, as they would
+   from the ui. Without an end the render stops two seconds after the last
+   event.
+
+   usage: SceneRenderer <sd card image> <scene name, such as SCENE1.SCN> <timeline file> <output wav>
+
+   ==============================================================================
+   */
+
+#include "AudioConstants.hpp"
+#include "CPPFile.hpp"
+#include "MnemonicAudioManager.hpp"
+#include "MnemonicConstants.hpp"
+#include "SceneLoader.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+constexpr unsigned int AXI_SRAM_SIZE = 524288; // 512kB, as on the target
+constexpr double SECONDS_AFTER_LAST_EVENT = 2.0;
+constexpr unsigned int DAC_TO_WAV_SHIFT = 4; // 12-bit dac samples to 16-bit wav samples
+
+static uint8_t axiSram[AXI_SRAM_SIZE];
+static int16_t writeBufferL[ABUFFER_SIZE];
+static int16_t writeBufferR[ABUFFER_SIZE];
+
+struct TimelineEvent
+{
+	unsigned int 	m_Block;
+	bool 		m_Play;
+	unsigned int 	m_CellX;
+	unsigned int 	m_CellY;
+};
+
+static unsigned int secondsToBlocks (double seconds)
+{
+	return static_cast<unsigned int>( (seconds * MNEMONIC_SAMPLE_RATE) / ABUFFER_SIZE );
+}
+
+// returns false if the timeline couldn't be read, numBlocks is set to the length of the render
+static bool readTimeline (const char* filename, std::vector<TimelineEvent>& events, unsigned int& numBlocks)
+{
+	std::ifstream timelineFile( filename );
+	if ( ! timelineFile.is_open() ) return false;
+
+	double lastEventSeconds = 0.0;
+	double endSeconds = -1.0;
+	std::string line;
+	unsigned int lineNum = 0;
+	while ( std::getline(timelineFile, line) )
+	{
+		lineNum++;
+		if ( line.empty() || line[0] == '#' ) continue;
+
+		std::istringstream lineStream( line );
+		double seconds = 0.0;
+		std::string action;
+		if ( ! (lineStream >> seconds >> action) || seconds < 0.0 )
+		{
+			std::printf( "%s:%u: expected a time in seconds and an action\n", filename, lineNum );
+			return false;
+		}
+
+		if ( action == "end" )
+		{
+			endSeconds = seconds;
+			continue;
+		}
+
+		TimelineEvent event;
+		if ( (action != "play" && action != "stop") || ! (lineStream >> event.m_CellX >> event.m_CellY) )
+		{
+			std::printf( "%s:%u: expected play or stop followed by a cell x and y\n", filename, lineNum );
+			return false;
+		}
+		event.m_Block = secondsToBlocks( seconds );
+		event.m_Play = ( action == "play" );
+		events.push_back( event );
+
+		lastEventSeconds = std::max( lastEventSeconds, seconds );
+	}
+
+	// events at the same time keep their order in the file
+	std::stable_sort( events.begin(), events.end(), [](const TimelineEvent& a, const TimelineEvent& b) {
+			return a.m_Block < b.m_Block; } );
+
+	numBlocks = secondsToBlocks( (endSeconds >= 0.0) ? endSeconds : lastEventSeconds + SECONDS_AFTER_LAST_EVENT );
+
+	return true;
+}
+
+static void writeLittleEndian (std::ofstream& file, uint32_t value, unsigned int numBytes)
+{
+	for ( unsigned int byte = 0; byte < numBytes; byte++ )
+	{
+		file.put( static_cast<char>((value >> (byte * 8)) & 0xFF) );
+	}
+}
+
+static void writeWavHeader (std::ofstream& file, unsigned int numFrames)
+{
+	const unsigned int numChannels = 2;
+	const unsigned int bytesPerSample = 2;
+	const uint32_t dataSizeInBytes = numFrames * numChannels * bytesPerSample;
+
+	file.write( "RIFF", 4 );
+	writeLittleEndian( file, 36 + dataSizeInBytes, 4 );
+	file.write( "WAVE", 4 );
+
+	file.write( "fmt ", 4 );
+	writeLittleEndian( file, 16, 4 ); // fmt chunk size
+	writeLittleEndian( file, 1, 2 ); // pcm
+	writeLittleEndian( file, numChannels, 2 );
+	writeLittleEndian( file, MNEMONIC_SAMPLE_RATE, 4 );
+	writeLittleEndian( file, MNEMONIC_SAMPLE_RATE * numChannels * bytesPerSample, 4 ); // byte rate
+	writeLittleEndian( file, numChannels * bytesPerSample, 2 ); // block align
+	writeLittleEndian( file, bytesPerSample * 8, 2 );
+
+	file.write( "data", 4 );
+	writeLittleEndian( file, dataSizeInBytes, 4 );
+}
+
+int main (int argc, char* argv[])
+{
+	if ( argc < 5 )
+	{
+		std::printf( "usage: %s <sd card image> <scene name, such as SCENE1.SCN> <timeline file> <output wav>\n", argv[0] );
+		return 1;
+	}
+
+	std::vector<TimelineEvent> events;
+	unsigned int numBlocks = 0;
+	if ( ! readTimeline(argv[3], events, numBlocks) )
+	{
+		std::printf( "couldn't read timeline %s\n", argv[3] );
+		return 1;
+	}
+
+	CPPFile sdCard( argv[1] );
+	MnemonicAudioManager audioManager( sdCard, axiSram, sizeof(axiSram) );
+	audioManager.bindToMnemonicParameterEventSystem();
+
+	SceneLoaderUiListener uiListener;
+	uiListener.bindToMnemonicUiEventSystem();
+
+	audioManager.verifyFileSystem();
+	if ( ! LoadScene(uiListener, argv[2]) )
+	{
+		std::printf( "couldn't find scene %s\n", argv[2] );
+		return 1;
+	}
+
+	std::ofstream wavFile( argv[4], std::ios::binary );
+	if ( ! wavFile.is_open() )
+	{
+		std::printf( "couldn't open %s for writing\n", argv[4] );
+		return 1;
+	}
+	writeWavHeader( wavFile, numBlocks * ABUFFER_SIZE );
+
+	const auto startTime = std::chrono::steady_clock::now();
+	std::vector<TimelineEvent>::const_iterator nextEvent = events.begin();
+	for ( unsigned int block = 0; block < numBlocks; block++ )
+	{
+		for ( ; nextEvent != events.end() && nextEvent->m_Block <= block; nextEvent++ )
+		{
+			PlayOrStopCell( nextEvent->m_CellX, nextEvent->m_CellY, nextEvent->m_Play );
+		}
+
+		std::memset( writeBufferL, 0, sizeof(writeBufferL) );
+		std::memset( writeBufferR, 0, sizeof(writeBufferR) );
+
+		audioManager.call( writeBufferL, writeBufferR );
+
+		for ( unsigned int sample = 0; sample < ABUFFER_SIZE; sample++ )
+		{
+			writeLittleEndian( wavFile, static_cast<uint16_t>(writeBufferL[sample] * (1 << DAC_TO_WAV_SHIFT)), 2 );
+			writeLittleEndian( wavFile, static_cast<uint16_t>(writeBufferR[sample] * (1 << DAC_TO_WAV_SHIFT)), 2 );
+		}
+
+		// what the main loop does between blocks
+		audioManager.getMidiEventsToSend().clear();
+		audioManager.publishUiEvents();
+	}
+	const double elapsedSeconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - startTime ).count();
+
+	const double renderedSeconds = ( static_cast<double>(numBlocks) * ABUFFER_SIZE ) / MNEMONIC_SAMPLE_RATE;
+	std::printf( "rendered %.2f s of %s (%u cells loaded, %u timeline events) to %s in %.2f s, %.1fx real time, %u underruns\n",
+			renderedSeconds, argv[2], static_cast<unsigned int>(uiListener.m_LoadedCells.size()),
+			static_cast<unsigned int>(events.size()), argv[4], elapsedSeconds,
+			(elapsedSeconds > 0.0) ? renderedSeconds / elapsedSeconds : 0.0, uiListener.m_NumUnderruns );
+
+	return 0;
+}
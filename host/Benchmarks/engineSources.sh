@@ -0,0 +1,11 @@
+# the sources and include paths needed to run MnemonicAudioManager without JUCE, sourced by the engine tool scripts
+ENGINE_INCLUDES="-I../../include -I../../lib/SAL/include -I../../lib/SFAT/include -I../../lib/DevLib/include"
+ENGINE_SRC="../../src/MnemonicAudioManager.cpp ../../src/IMnemonicParameterEventListener.cpp \
+	../../src/IMnemonicUiEventListener.cpp ../../src/AudioTrack.cpp ../../src/B12DecodeMix.cpp ../../src/MasterLimiter.cpp \
+	../../src/B12Container.cpp ../../src/Fat16SectorStream.cpp ../../src/Fat16DirectoryIndex.cpp \
+	../../src/BlockingStorageMedia.cpp ../../src/MidiTrack.cpp ../../src/MnemonicProfiler.cpp ../../src/PolyphaseResampler.cpp \
+	../../src/LoopCalendar.cpp ../../src/MidiSampleClock.cpp \
+	../../lib/SAL/src/B12Compression.cpp ../../lib/SAL/src/IMidiEventListener.cpp \
+	../../lib/SFAT/src/BootSector.cpp ../../lib/SFAT/src/Fat16Entry.cpp ../../lib/SFAT/src/Fat16FileManager.cpp \
+	../../lib/SFAT/src/IFatFileManager.cpp ../../lib/SFAT/src/PartitionTable.cpp \
+	../../lib/DevLib/src/CPPFile.cpp ../../lib/DevLib/src/IAllocator.cpp"
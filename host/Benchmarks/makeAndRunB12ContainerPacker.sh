@@ -0,0 +1,4 @@
+# usage: ./makeAndRunB12ContainerPacker.sh <output b12> <sample rate in Hz> <left or mono b12> [right b12]
+mkdir -p build
+g++ -std=c++20 -O2 -DNDEBUG -I../../include B12ContainerPacker.cpp ../../src/B12Container.cpp -o build/B12ContainerPacker
+./build/B12ContainerPacker "$@"
@@ -0,0 +1,5 @@
+mkdir -p build
+g++ -std=c++20 -O2 -march=native -DNDEBUG -I../../include -I../../lib/SAL/include -I../../lib/DevLib/include \
+	B12DecodeMixBenchmark.cpp ../../src/B12DecodeMix.cpp ../../src/MasterLimiter.cpp ../../src/PolyphaseResampler.cpp \
+	../../lib/SAL/src/B12Compression.cpp ../../lib/DevLib/src/IAllocator.cpp -o build/B12DecodeMixBenchmark
+./build/B12DecodeMixBenchmark
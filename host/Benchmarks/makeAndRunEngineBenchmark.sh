@@ -0,0 +1,5 @@
+# usage: ./makeAndRunEngineBenchmark.sh <sd card image> <scene name> [seconds per run]
+. ./engineSources.sh
+mkdir -p build
+g++ -std=c++20 -O2 -march=native -DNDEBUG -pthread $ENGINE_INCLUDES EngineBenchmark.cpp $ENGINE_SRC -o build/EngineBenchmark
+./build/EngineBenchmark "$@"
@@ -0,0 +1,5 @@
+# usage: ./makeAndRunSceneRenderer.sh <sd card image> <scene name> <timeline file> <output wav>
+. ./engineSources.sh
+mkdir -p build
+g++ -std=c++20 -O2 -march=native -DNDEBUG -pthread $ENGINE_INCLUDES SceneRenderer.cpp $ENGINE_SRC -o build/SceneRenderer
+./build/SceneRenderer "$@"
@@ -34,6 +34,9 @@ MainComponent::MainComponent() :
 	fakeNeotrellis(),
 	midiHandler(),
 	midiHandlerFakeSynth(),
+	midiSampleClock(),
+	midiOutputScheduler(),
+	midiOutputQueue(),
 	lastInputIndex( 0 ),
 	sAudioBuffer(),
 	fakeSynth1( 1 ),
@@ -42,7 +45,8 @@ MainComponent::MainComponent() :
 	fakeSynth4( 4 ),
 	fakeAxiSram{ 0 },
 	sdCard( "SDCard.img" ),
-	audioManager( sdCard, fakeAxiSram, sizeof(fakeAxiSram) ),
+	asyncSdCard( "SDCard.img" ),
+	audioManager( sdCard, fakeAxiSram, sizeof(fakeAxiSram), &asyncSdCard ),
 	writer(),
 	effect1Sldr(),
 	effect1Lbl(),
@@ -57,7 +61,8 @@ MainComponent::MainComponent() :
 	midiInputListLbl(),
 	audioSettingsComponent( deviceManager, 2, 2, &audioSettingsBtn ),
 	uiManager( 128, 64, CP_FORMAT::MONOCHROME_1BIT, &fakeNeotrellis ),
-	screenRep( juce::Image::RGB, 256, 128, true ) // this is actually double the size so we can actually see it
+	screenRep( juce::Image::RGB, 256, 128, true ), // this is actually double the size so we can actually see it
+	streamTelemetry()
 {
 	// FLUSH DENORMALS TO ZERO!
 	_MM_SET_FLUSH_ZERO_MODE( _MM_FLUSH_ZERO_ON );
@@ -72,9 +77,15 @@ MainComponent::MainComponent() :
 	this->bindToMnemonicLCDRefreshEventSystem();
 	audioManager.bindToMnemonicParameterEventSystem();
 	audioManager.bindToMidiEventSystem();
+	audioManager.setMidiSampleClock( &midiSampleClock );
 	uiManager.bindToPotEventSystem();
 	uiManager.bindToButtonEventSystem();
 	uiManager.bindToMnemonicUiEventSystem();
+	this->bindToMnemonicUiEventSystem();
+
+#ifdef MNEMONIC_PROFILING
+	MnemonicProfiler::Enable( 0 );
+#endif
 	fakeSynth1.bindToKeyEventSystem();
 	fakeSynth2.bindToKeyEventSystem();
 	fakeSynth3.bindToKeyEventSystem();
@@ -264,6 +275,9 @@ MainComponent::~MainComponent()
 	shutdownAudio();
 	delete writer;
 	testFile.close();
+
+	this->dumpStreamTelemetry( std::cout );
+	this->dumpProfile( std::cout );
 }
 
 bool MainComponent::keyPressed (const juce::KeyPress& k)
@@ -282,6 +296,14 @@ bool MainComponent::keyPressed (const juce::KeyPress& k)
 	{
 		effect2Btn.setState( juce::Button::ButtonState::buttonDown );
 	}
+	else if ( k.getTextCharacter() == 't' )
+	{
+		this->dumpStreamTelemetry( std::cout );
+	}
+	else if ( k.getTextCharacter() == 'p' )
+	{
+		this->dumpProfile( std::cout );
+	}
 
 	return true;
 }
@@ -302,17 +324,13 @@ void MainComponent::timerCallback()
 	// update transport and other periodic data
 	audioManager.publishUiEvents();
 
-	// these next lines are to simulate sending midi events over usart
-	std::vector<MidiEvent>& midiEventsToSendVec = audioManager.getMidiEventsToSendVec();
-	for ( const MidiEvent& midiEvent : midiEventsToSendVec )
+	// these next lines are to simulate sending midi events over usart, the audio callback releases them when they're due
+	// and sends them at the rate of the midi wire
+	TimedMidiEvent timedMidiEvent;
+	while ( audioManager.getMidiEventsToSend().pop(timedMidiEvent) )
 	{
-		const uint8_t* byteVal = midiEvent.getRawData();
-		for ( unsigned int byte = 0; byte < midiEvent.getNumBytes(); byte++ )
-		{
-			midiHandlerFakeSynth.processByte( byteVal[byte] );
-		}
+		midiOutputScheduler.schedule( timedMidiEvent );
 	}
-	midiEventsToSendVec.clear();
 
 	midiHandlerFakeSynth.dispatchEvents();
 
@@ -364,6 +382,10 @@ void MainComponent::prepareToPlay (int samplesPerBlockExpected, double sampleRat
 	// but be careful - it will be called on the audio thread, not the GUI thread.
 
 	// For more details, see the help for AudioProcessor::prepareToPlay()
+
+	// audio files recorded at another rate than the device's are resampled as they load
+	audioManager.setSampleRate( static_cast<unsigned int>(sampleRate) );
+	midiOutputQueue.setSampleRate( static_cast<unsigned int>(sampleRate) );
 }
 
 void MainComponent::getNextAudioBlock (const juce::AudioSourceChannelInfo& bufferToFill)
@@ -390,8 +412,19 @@ void MainComponent::getNextAudioBlock (const juce::AudioSourceChannelInfo& buffe
 			float sampleOutFloatR = static_cast<float>( (((sampleOutR + (4096 / 2)) / 4096.0f) * 2.0f) - 1.0f );
 			writePtrR[sample] = sampleOutFloatR;
 			writePtrL[sample] = sampleOutFloatL;
+
+			// as the dac timer and the midi usart do on the target
+			midiSampleClock.tick();
+			midiOutputScheduler.release( midiSampleClock.getSampleCount(), midiOutputQueue );
+			uint8_t midiByteSent = 0;
+			if ( midiOutputQueue.tick(midiByteSent) )
+			{
+				midiHandlerFakeSynth.processByte( midiByteSent );
+			}
 		}
 
+		// dispatched here rather than as the midi arrives, so the audio manager only produces midi from the audio thread
+		midiHandler.dispatchEvents();
 		sAudioBuffer.pollToFillBuffers();
 	}
 	catch ( std::exception& e )
@@ -553,10 +586,9 @@ void MainComponent::handleIncomingMidiMessage (juce::MidiInput *source, const ju
 {
 	for ( int byte = 0; byte < message.getRawDataSize(); byte++ )
 	{
+		midiSampleClock.onByteReceived( message.getRawData()[byte] );
 		midiHandler.processByte( message.getRawData()[byte] );
 	}
-
-	midiHandler.dispatchEvents();
 }
 
 void MainComponent::onMnemonicLCDRefreshEvent (const MnemonicLCDRefreshEvent& lcdRefreshEvent)
@@ -565,3 +597,67 @@ void MainComponent::onMnemonicLCDRefreshEvent (const MnemonicLCDRefreshEvent& lc
 					lcdRefreshEvent.getXEnd(), lcdRefreshEvent.getYEnd() );
 	this->repaint();
 }
+
+void MainComponent::onMnemonicUiEvent (const MnemonicUiEvent& event)
+{
+	if ( event.getEventType() == UiEventType::STREAM_TELEMETRY )
+	{
+		streamTelemetry = *static_cast<const UiStreamTelemetry*>( event.getDataPtr() );
+	}
+}
+
+void MainComponent::dumpStreamTelemetry (std::ostream& out) const
+{
+	out << "STREAM TELEMETRY: " << streamTelemetry.m_NumReads << " reads, worst latency "
+		<< streamTelemetry.m_WorstReadLatencyInBlocks << " blocks, " << streamTelemetry.m_NumUnderruns << " underruns" << std::endl;
+
+	out << "read latency in blocks:";
+	for ( unsigned int bucket = 0; bucket < MNEMONIC_SD_LATENCY_HISTOGRAM_BUCKETS; bucket++ )
+	{
+		const unsigned int bucketStart = ( bucket == 0 ) ? 0 : 1 << ( bucket - 1 );
+		const char* bucketEnd = ( bucket == MNEMONIC_SD_LATENCY_HISTOGRAM_BUCKETS - 1 ) ? "+" : "";
+		out << " [" << bucketStart << bucketEnd << "] " << streamTelemetry.m_ReadLatencyHistogram[bucket];
+	}
+	out << std::endl;
+
+	for ( unsigned int track = 0; track < streamTelemetry.m_NumTracks; track++ )
+	{
+		const UiStreamTrackTelemetry& trackTelemetry = streamTelemetry.m_Tracks[track];
+		out << "track " << trackTelemetry.m_CellX << "," << trackTelemetry.m_CellY << ": ";
+		if ( trackTelemetry.m_IsResident )
+		{
+			out << "resident" << std::endl;
+			continue;
+		}
+
+		out << trackTelemetry.m_NumUnderruns << " underruns, ring depth " << trackTelemetry.m_RingDepth << ", low-water mark ";
+		if ( trackTelemetry.m_MinBlocksBuffered == std::numeric_limits<unsigned int>::max() )
+		{
+			out << "none";
+		}
+		else
+		{
+			out << trackTelemetry.m_MinBlocksBuffered << " blocks";
+		}
+		out << std::endl;
+	}
+}
+
+void MainComponent::dumpProfile (std::ostream& out) const
+{
+#ifdef MNEMONIC_PROFILING
+	out << "PROFILE (nanoseconds per block, worst block as a percentage of the deadline):" << std::endl;
+	for ( unsigned int scopeNum = 0; scopeNum < MNEMONIC_PROFILE_NUM_SCOPES; scopeNum++ )
+	{
+		const ProfileScope scope = static_cast<ProfileScope>( scopeNum );
+		const ProfileStats& stats = MnemonicProfiler::GetStats( scope );
+		if ( stats.m_NumBlocks == 0 ) continue;
+
+		out << MnemonicProfiler::GetScopeName( scope ) << ": min " << stats.m_MinTicks << " avg "
+			<< MnemonicProfiler::GetAverageTicks( scope ) << " max " << stats.m_MaxTicks << " ("
+			<< MnemonicProfiler::GetWorstBlockPercentOfDeadline( scope ) << "%)" << std::endl;
+	}
+#else
+	(void) out;
+#endif
+}
@@ -11,13 +11,19 @@
 #include "../JuceLibraryCode/JuceHeader.h"
 #include "AudioBuffer.hpp"
 #include "MidiHandler.hpp"
+#include "MidiSampleClock.hpp"
+#include "MidiOutputScheduler.hpp"
+#include "WireRateMidiOutputQueue.hpp"
 #include "PresetManager.hpp"
 #include "AudioSettingsComponent.h"
 #include "MnemonicConstants.hpp"
 #include "MnemonicAudioManager.hpp"
 #include "MnemonicUiManager.hpp"
 #include "IMnemonicLCDRefreshEventListener.hpp"
+#include "IMnemonicUiEventListener.hpp"
+#include "MnemonicProfiler.hpp"
 #include "CPPFile.hpp"
+#include "ThreadedStorageMedia.hpp"
 #include "FakeSynth.hpp"
 #include "Neotrellis.hpp"
 
@@ -127,7 +133,8 @@ class FakeNeotrellis : public NeotrellisInterface
    your controls and content.
    */
 class MainComponent   : public juce::AudioAppComponent, public juce::Slider::Listener, public juce::Button::Listener,
-			public juce::MidiInputCallback, public juce::Timer, public IMnemonicLCDRefreshEventListener
+			public juce::MidiInputCallback, public juce::Timer, public IMnemonicLCDRefreshEventListener,
+			public IMnemonicUiEventListener
 {
 	public:
 		//==============================================================================
@@ -160,6 +167,9 @@ class MainComponent   : public juce::AudioAppComponent, public juce::Slider::Lis
 
 		void onMnemonicLCDRefreshEvent (const MnemonicLCDRefreshEvent& lcdRefreshEvent) override;
 
+		// keeps the latest streaming telemetry, which is dumped with the 't' key and on exit
+		void onMnemonicUiEvent (const MnemonicUiEvent& event) override;
+
 	private:
 		//==============================================================================
 		// Your private member variables go here...
@@ -167,6 +177,9 @@ class MainComponent   : public juce::AudioAppComponent, public juce::Slider::Lis
 		FakeNeotrellis fakeNeotrellis;
 		MidiHandler midiHandler;
 		MidiHandler midiHandlerFakeSynth;
+		MidiSampleClock midiSampleClock;
+		MidiOutputScheduler midiOutputScheduler;
+		WireRateMidiOutputQueue midiOutputQueue;
 		int lastInputIndex;
 		::AudioBuffer<int16_t, true> sAudioBuffer;
 		FakeSynth fakeSynth1;
@@ -177,6 +190,7 @@ class MainComponent   : public juce::AudioAppComponent, public juce::Slider::Lis
 		uint8_t fakeAxiSram[524288]; // 512kB
 
 		CPPFile sdCard;
+		ThreadedStorageMedia asyncSdCard;
 
 		MnemonicAudioManager audioManager;
 
@@ -205,6 +219,10 @@ class MainComponent   : public juce::AudioAppComponent, public juce::Slider::Lis
 
 		std::ofstream testFile;
 
+		UiStreamTelemetry streamTelemetry;
+		void dumpStreamTelemetry (std::ostream& out) const;
+		void dumpProfile (std::ostream& out) const; // only prints anything if built with MNEMONIC_PROFILING
+
 		void copyFrameBufferToImage (unsigned int xStart, unsigned int yStart, unsigned int xEnd, unsigned int yEnd);
 
 		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MainComponent)
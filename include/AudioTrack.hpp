@@ -3,25 +3,49 @@
 
 /*************************************************************************
  * An AudioTrack defines a stream of double buffered b12 encoded audio
- * and utilities for decoding the data. The user should continuously
- * check the shouldFillNextBuffer function and fill the buffer accordingly.
+ * and utilities for decoding the data. Filling the circular buffer is
+ * left to the owner, which should check needsNextSector and call
+ * submitNextSectors for the tracks closest to underrunning first (see
+ * getBlocksUntilUnderrun), then pollPendingRead until the read lands.
+ * A track has at most one read in flight, which targets the circular
+ * buffer itself, though whether it lands there without a copy is up
+ * to the backend (see BlockingStorageMedia). The call function only
+ * decodes, adding the track to the 32-bit mix buses (see
+ * MasterLimiter).
+ *
+ * Note: The circular buffer depth is a number of ring units, each unit
+ * being three sectors so that sectors and compressed audio blocks, mono
+ * or interleaved stereo (see B12Container), both tile the buffer
+ * exactly. Tracks start with one unit and the owner may resize them
+ * with setRingDepth. Short tracks can instead be made resident, which
+ * reads the whole file into memory once so that playing never touches
+ * the storage media again. Looping tracks can keep a loop head, the
+ * first few sectors of the file, which play splices into the circular
+ * buffer so a restart is decodable straight away without a read.
+ * Files at a sample rate other than the output's are decoded a chunk
+ * at a time into a PolyphaseResampler, so each block consumes as much
+ * of the file as the rates call for and lengths are in output blocks.
 *************************************************************************/
 
 #include "AudioConstants.hpp"
-#include "IBufferCallback.hpp"
+#include "B12DecodeMix.hpp"
 #include "Fat16Entry.hpp"
+#include "Fat16SectorStream.hpp"
+#include "IAsyncStorageMedia.hpp"
+#include "MnemonicConstants.hpp"
+#include "PolyphaseResampler.hpp"
 #include "SharedData.hpp"
 #include <stdint.h>
 
 class IAllocator;
-class Fat16FileManager;
 
-class AudioTrack : public IBufferCallback<int16_t, true>
+class AudioTrack
 {
 	public:
-		AudioTrack (unsigned int cellX, unsigned int cellY, Fat16FileManager* fileManager, const Fat16Entry& entry,
-				unsigned int b12BufferSizes, IAllocator& allocator, uint16_t* decompressedBuffer);
-		~AudioTrack() override;
+		AudioTrack (unsigned int cellX, unsigned int cellY, const Fat16SectorStream& stream, IAsyncStorageMedia& storageMedia,
+				const Fat16Entry& entry, unsigned int numChannels, unsigned int b12BufferSizes, IAllocator& allocator,
+				unsigned int sampleRate = MNEMONIC_SAMPLE_RATE, unsigned int outputSampleRate = MNEMONIC_SAMPLE_RATE);
+		~AudioTrack();
 
 		bool operator== (const AudioTrack& other) const;
 
@@ -31,46 +55,102 @@ class AudioTrack : public IBufferCallback<int16_t, true>
 		Fat16Entry getFatEntry() const { return m_FatEntry; }
 
 		unsigned int getFileLengthInAudioBlocks() const { return m_FileLengthInAudioBlocks; }
-
-		bool shouldFillNextBuffer();
-		void fillNextBuffer (const uint8_t* const compressedBuf);
+		unsigned int getNumChannels() const { return m_NumChannels; }
+		bool isResampling() const { return m_Resampler.isActive(); }
+
+		bool shouldFillNextBuffer() const;
+
+		bool needsNextSector() const; // true if playing, no read is in flight and there is room in the circular buffer
+		unsigned int submitNextSectors (unsigned int maxSectors); // submits one read of up to maxSectors, returns the number submitted
+		bool pollPendingRead(); // advances the circular buffer once the read in flight has landed, returns true if it just did
+		unsigned int getNumSectorsToFill() const; // the number of sectors that can be written contiguously into the buffer
+		unsigned int getBlocksUntilUnderrun() const; // the number of audio blocks that can be decoded before starving
+		unsigned int getLastReadLatencyInBlocks() const { return m_LastReadLatencyInBlocks; }
+
+		// an underrun is a block the track had to skip because its read hadn't landed yet, the low-water mark is the fewest
+		// blocks buffered when a block was decoded, both only counting once the track has started decoding after play
+		unsigned int getNumUnderruns() const { return m_NumUnderruns; }
+		unsigned int getMinBlocksBuffered() const { return m_MinBlocksBuffered; }
+
+		// keeps any buffered audio and the loop head, so it is never shrunk below either
+		void setRingDepth (unsigned int numRingUnits);
+		unsigned int getRingDepth() const { return m_B12CircularBufferSize / this->getRingUnitSizeInBytes(); }
+		unsigned int getRingUnitSizeInBytes() const { return m_B12BufferSize * 3; }
+		unsigned int getRingUnitSizeInAudioBlocks() const; // at least 1, even if a block consumes more than a unit
+		// the ring units that keep numAudioBlocks buffered with room for the next sector to land, rounding up partial units
+		unsigned int getRingUnitsToCover (unsigned int numAudioBlocks) const;
+
+		// reads the whole file into memory, returns false and keeps streaming if it couldn't be read
+		bool makeResident();
+		bool isResident() const { return m_IsResident; }
+		unsigned int getResidentSizeInBytes() const; // the memory needed to make this track resident
+
+		// keeps the first numSectors of the file in memory for play to restart from, returns false if they couldn't be read
+		bool loadLoopHead (unsigned int numSectors);
+		unsigned int getLoopHeadSizeInBytes() const { return m_LoopHeadSizeInBytes; }
 
 		void play();
 		void reset();
 
-		bool isPlaying() { return m_FatEntry.getFileTransferInProgressFlagRef(); }
+		bool isPlaying() const { return m_IsPlaying; }
 		bool justFinished() { const bool justFinished = m_JustFinished; m_JustFinished = false; return justFinished; }
 
 		void setLoopable (const bool isLoopable, const bool loopWaitForZero = false);
 		bool isLoopable() const { return m_IsLoopable; }
 		void setLoopLength (unsigned int currentMaxLoopLength);
+		unsigned int getLoopLengthInAudioBlocks() const { return m_LoopLengthInAudioBlocks; }
 		bool shouldLoop (const unsigned int masterClockCount); // loops if clock count is divisible
+		// false if shouldLoop can't return true at any clock count, so the track doesn't need its loop boundaries checked
+		bool needsLoopBoundaries() const { return m_IsLoopable || m_LoopWaitForZero; }
 
 		void setAmplitudes (const float amplitudeL, const float amplitudeR);
 
-		void call (int16_t* writeBufferL, int16_t* writeBufferR) override;
+		void call (int32_t* mixBusL, int32_t* mixBusR);
 
 	private:
 		unsigned int 		m_CellX;
 		unsigned int 		m_CellY;
 
-		Fat16FileManager* 	m_FileManager;
+		Fat16SectorStream 	m_Stream;
+		IAsyncStorageMedia* 	m_StorageMedia;
+		unsigned int 		m_PendingReadId; // ASYNC_STORAGE_INVALID_REQUEST if no read is in flight
+		unsigned int 		m_PendingReadNumSectors;
+		unsigned int 		m_PendingReadNumPolls;
+		unsigned int 		m_LastReadLatencyInBlocks; // how many audio blocks the last read took to land
 		Fat16Entry 		m_FatEntry;
 
+		unsigned int 		m_NumChannels; // 2 for interleaved stereo files
+		unsigned int 		m_BlockSizeInBytes; // the compressed size of one audio block across all channels
+		unsigned int 		m_BytesPerOutputBlock; // the compressed bytes an output block consumes, rounded up if resampling
+
 		unsigned int 		m_FileLengthInAudioBlocks;
 		unsigned int 		m_LoopLengthInAudioBlocks;
 
 		unsigned int 		m_B12BufferSize;
 
+		IAllocator* 		m_Allocator;
 		unsigned int 		m_B12CircularBufferSize;
 		SharedData<uint8_t>     m_B12CircularBuffer;
 		unsigned int 		m_B12WritePos;
 		unsigned int 		m_B12ReadPos;
 
-		uint16_t*     		m_DecompressedBuffer;
+		int16_t 		m_GainL; // q14, see B12DecodeMix
+		int16_t 		m_GainR;
+		B12DecodeMixFunction 	m_DecodeMix; // specialised for the gains and channel count, reselected whenever they change
+
+		PolyphaseResampler 	m_Resampler; // only active if the file's sample rate differs from the output's
+		B12DecodeMixFunction 	m_DecodeResamplerInput; // decodes at unity gain for the resampler to apply the gains after
+
+		bool 			m_IsResident; // the circular buffer holds the whole file and is never refilled
 
-		float 			m_AmplitudeL;
-		float 			m_AmplitudeR;
+		bool 			m_HasStartedDecoding; // false from play until the first block is decoded, so start up isn't an underrun
+		unsigned int 		m_NumUnderruns;
+		unsigned int 		m_MinBlocksBuffered; // reset whenever the ring is resized
+
+		SharedData<uint8_t> 	m_LoopHead;
+		unsigned int 		m_LoopHeadSizeInBytes; // 0 if there is no loop head
+		Fat16SectorStream 	m_LoopHeadStream; // the stream just past the loop head, so restarting doesn't touch the fat
+		bool 			m_IsPlaying; // true while there is still file left to stream, or to decode if resident
 
 		bool 			m_IsLoopable;
 		bool 			m_LoopWaitForZero; // only start/stop looping if master clock = 0
@@ -80,8 +160,19 @@ class AudioTrack : public IBufferCallback<int16_t, true>
 
 		uint8_t* getBuffer (bool writeBuffer);
 
+		void completePendingRead();
+
+		// reads from the start of the file until maxBytes or the end of the file, returns the number of bytes read
+		unsigned int readFromStart (uint8_t* dest, unsigned int maxBytes);
+		void restartFromLoopHead();
+
+		unsigned int getBytesToDecode() const; // the compressed bytes the next block needs
+		unsigned int getMaxBytesToDecode() const; // the most any block can need
+		void advanceReadPos (unsigned int numBytes);
+
 		bool shouldDecompress();
-		void decompressToBuffer (int16_t* writeBufferL, int16_t* writeBufferR);
+		void decompressToBuffer (int32_t* mixBusL, int32_t* mixBusR);
+		void resampleToBuffer (int32_t* mixBusL, int32_t* mixBusR);
 };
 
 #endif // AUDIOTRACK_HPP
@@ -0,0 +1,44 @@
+#ifndef B12CONTAINER_HPP
+#define B12CONTAINER_HPP
+
+/*******************************************************************
+ * A B12Container describes the optional header at the start of a
+ * b12 file. Plain b12 files have no header and hold a single
+ * channel at MNEMONIC_SAMPLE_RATE. A b12 file starting with the
+ * header holds one channel or interleaved stereo, so a stereo clip
+ * can be streamed and decoded as a single track instead of a pair
+ * of L/R files, and records the rate it was encoded at so that
+ * clips at other rates are resampled (see PolyphaseResampler).
+ *
+ * The header takes up the whole first sector (512 bytes) so that
+ * the audio data after it stays sector aligned. All values are
+ * little endian:
+ *   bytes 0-3 : magic "B12S"
+ *   byte  4   : version (2, version 1 headers are still read)
+ *   byte  5   : number of channels (1 or 2, always 2 in version 1)
+ *   bytes 6-7 : frames per interleaved chunk (64)
+ *   bytes 8-11: sample rate in Hz (version 2 only)
+ *   bytes 12+ : reserved, zero
+ * After the header, stereo channels alternate every chunk: 64 left
+ * samples (96 bytes of b12 data) then 64 right samples, and so on.
+*******************************************************************/
+
+#include <stdint.h>
+
+constexpr unsigned int B12_CONTAINER_HEADER_SIZE = 512;
+constexpr unsigned int B12_CONTAINER_VERSION = 2;
+
+struct B12ContainerHeader
+{
+	unsigned int 	m_NumChannels = 1;
+	unsigned int 	m_HeaderSizeInBytes = 0; // 0 for plain b12 files
+	unsigned int 	m_SampleRate = 0; // 0 if not recorded, in which case it is MNEMONIC_SAMPLE_RATE
+};
+
+// reads the header from the first bytes of a b12 file, returns false if the header is present but not one this build can play
+bool B12ReadContainerHeader (const uint8_t* data, unsigned int sizeInBytes, B12ContainerHeader& header);
+
+// writes a header, data must hold B12_CONTAINER_HEADER_SIZE bytes (see host/Benchmarks/B12ContainerPacker.cpp)
+void B12WriteContainerHeader (uint8_t* data, unsigned int numChannels, unsigned int sampleRate);
+
+#endif // B12CONTAINER_HPP
@@ -0,0 +1,47 @@
+#ifndef B12DECODEMIX_HPP
+#define B12DECODEMIX_HPP
+
+/*******************************************************************
+ * B12DecodeMix decodes b12 compressed audio and accumulates it into
+ * a pair of int32 mix buses in a single pass. Each step unpacks a
+ * few 12-bit pairs straight into registers, then recentres, halves,
+ * scales by the q14 gains and adds them to both buses, so nothing
+ * is ever written out as decompressed samples. The best packed SIMD
+ * path is picked at compile time: the DSP extension on Cortex-M7,
+ * AVX2 or SSE2 on host, or a plain loop otherwise.
+ * Each bus is also specialised for a zero gain (skipped) and a
+ * unity gain (no multiply), so a track should pick its variant
+ * with B12SelectDecodeMix whenever its gains change, rather than
+ * paying for the generic path every block.
+ *
+ * Note: All paths produce exactly the same output as the scalar
+ * reference, which still unpacks with B12Decompress and so pins
+ * the bit layout the fused paths assume. numSamples must be a
+ * multiple of B12_DECODE_MIX_CHUNK_SIZE.
+*******************************************************************/
+
+#include <stdint.h>
+
+constexpr unsigned int B12_DECODE_MIX_CHUNK_SIZE = 64; // in samples, 96 bytes of b12 data
+constexpr int16_t B12_DECODE_MIX_UNITY_GAIN = 1 << 14;
+
+int16_t B12GainFromAmplitude (const float amplitude); // amplitude to a q14 gain, clamped to the representable range
+
+typedef void (*B12DecodeMixFunction) (const uint8_t* compressed, unsigned int numSamples, int32_t* busL, int32_t* busR,
+					int16_t gainL, int16_t gainR);
+
+// the variant specialised for these gains, the gains must still be passed to it when called
+B12DecodeMixFunction B12SelectDecodeMix (const int16_t gainL, const int16_t gainR, const bool interleavedStereo);
+
+// the generic path for any gains, the fastest available for this build
+void B12DecodeMix (const uint8_t* compressed, unsigned int numSamples, int32_t* busL, int32_t* busR, int16_t gainL, int16_t gainR);
+
+// the same for an interleaved stereo stream (see B12Container), numFrames must be a multiple of B12_DECODE_MIX_CHUNK_SIZE
+void B12DecodeMixStereo (const uint8_t* compressed, unsigned int numFrames, int32_t* busL, int32_t* busR, int16_t gainL,
+				int16_t gainR);
+
+// the portable reference the SIMD paths are checked against
+void B12DecodeMixScalar (const uint8_t* compressed, unsigned int numSamples, int32_t* busL, int32_t* busR, int16_t gainL,
+				int16_t gainR);
+
+#endif // B12DECODEMIX_HPP
@@ -0,0 +1,36 @@
+#ifndef BLOCKINGSTORAGEMEDIA_HPP
+#define BLOCKINGSTORAGEMEDIA_HPP
+
+/*******************************************************************
+ * A BlockingStorageMedia adapts a regular IStorageMedia to the
+ * IAsyncStorageMedia interface by performing each read as soon
+ * as it is submitted, so every request is already complete when
+ * it is first polled. This is what is used until the storage
+ * driver can complete reads on its own.
+ *
+ * Note: IStorageMedia can only return a buffer of its own, so
+ * unless the driver also implements IReadIntoStorageMedia each
+ * read is copied once from that buffer into the destination.
+*******************************************************************/
+
+#include "IAsyncStorageMedia.hpp"
+
+class IStorageMedia;
+class IReadIntoStorageMedia;
+
+class BlockingStorageMedia : public IAsyncStorageMedia
+{
+	public:
+		// reads go straight into the destination through readIntoMedia if given, which should be the same media
+		BlockingStorageMedia (IStorageMedia& storageMedia, IReadIntoStorageMedia* readIntoMedia = nullptr);
+		~BlockingStorageMedia() override;
+
+		unsigned int submitRead (uint8_t* destination, unsigned int sizeInBytes, unsigned int byteAddress) override;
+		bool pollRead (unsigned int requestId) override;
+
+	private:
+		IStorageMedia& 			m_StorageMedia;
+		IReadIntoStorageMedia* 		m_ReadIntoMedia;
+};
+
+#endif // BLOCKINGSTORAGEMEDIA_HPP
@@ -0,0 +1,69 @@
+#ifndef FAT16DIRECTORYINDEX_HPP
+#define FAT16DIRECTORYINDEX_HPP
+
+/*************************************************************************
+ * A Fat16DirectoryIndex maps the 8.3 names in a directory to the index
+ * of their entry in the file manager's directory entries, so a file can
+ * be found by name without scanning the directory. Names are normalised
+ * to the raw space padded upper case form, so "kick.b12" and "KICK.B12"
+ * find the same entry.
+ *
+ * Note: The index is an open addressing hash table allocated in one
+ * block, which is only reallocated when it grows past three quarters
+ * full. It has to be kept up to date by calling insert and remove
+ * whenever entries are created or deleted.
+*************************************************************************/
+
+#include "Fat16Entry.hpp"
+#include "SharedData.hpp"
+#include <stdint.h>
+#include <vector>
+
+class IAllocator;
+
+constexpr unsigned int FAT16_DIRECTORY_INDEX_KEY_SIZE = FAT16_FILENAME_SIZE + FAT16_EXTENSION_SIZE;
+constexpr unsigned int FAT16_DIRECTORY_INDEX_MIN_SLOTS = 32; // must be a power of two
+
+struct Fat16DirectoryIndexSlot
+{
+	char 		m_Key[FAT16_DIRECTORY_INDEX_KEY_SIZE];
+	uint8_t 	m_State;
+	unsigned int 	m_EntryIndex;
+};
+
+class Fat16DirectoryIndex
+{
+	public:
+		Fat16DirectoryIndex();
+		~Fat16DirectoryIndex();
+
+		// indexes every entry that isn't deleted, the entry index being the position in entries
+		void build (const std::vector<Fat16Entry*>& entries, IAllocator* allocator = nullptr);
+		void clear();
+
+		// finds a display name such as "KICK.B12", optionally with its extension replaced, returns false if not found
+		bool find (const char* filenameDisplay, unsigned int& entryIndex, const char* extension = nullptr) const;
+		bool findRaw (const char* filenameRaw, const char* extensionRaw, unsigned int& entryIndex) const;
+
+		void insert (const Fat16Entry& entry, unsigned int entryIndex);
+		void remove (const Fat16Entry& entry);
+
+		unsigned int getNumEntries() const { return m_NumEntries; }
+
+	private:
+		IAllocator* 				m_Allocator;
+		mutable SharedData<Fat16DirectoryIndexSlot> m_Slots; // SharedData has no const access
+		unsigned int 				m_NumSlots; // 0 until built, otherwise a power of two
+		unsigned int 				m_NumEntries;
+		unsigned int 				m_NumRemoved; // removed slots still lengthen probes until the next rehash
+
+		void insertKey (const char* key, unsigned int entryIndex);
+		bool findKey (const char* key, unsigned int& slotIndex) const;
+		void rehash (unsigned int numSlots);
+
+		static void MakeKeyFromDisplay (const char* filenameDisplay, const char* extension, char* key);
+		static void MakeKeyFromRaw (const char* filenameRaw, const char* extensionRaw, char* key);
+		static uint32_t Hash (const char* key);
+};
+
+#endif // FAT16DIRECTORYINDEX_HPP
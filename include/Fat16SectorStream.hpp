@@ -0,0 +1,114 @@
+#ifndef FAT16SECTORSTREAM_HPP
+#define FAT16SECTORSTREAM_HPP
+
+/*************************************************************************
+ * A Fat16SectorStream reads a file on a fat16 volume straight from the
+ * storage media. It follows the file's cluster chain itself, so that
+ * when consecutive clusters are contiguous on the media several sectors
+ * can be fetched with a single read instead of one read per sector.
+ *
+ * Owners that stream the same file repeatedly should build an extent
+ * map, which walks the chain once and keeps it as runs of contiguous
+ * clusters. After that, finding the next sector is a lookup in the map
+ * and the file allocation table isn't read again.
+ *
+ * Note: The Fat16Geometry is read from the boot sector of the volume the
+ * Fat16FileManager mounted, and a file's starting cluster from its raw
+ * directory entry, since SFAT doesn't expose either. All addresses are
+ * in bytes. The stream only reads the file allocation table itself,
+ * reading the file data is left to the owner so that it can be done
+ * asynchronously (see IAsyncStorageMedia).
+*************************************************************************/
+
+#include "SharedData.hpp"
+#include <stdint.h>
+
+class IStorageMedia;
+class IAllocator;
+class Fat16FileManager;
+
+struct Fat16Geometry
+{
+	bool 		m_IsValid = false;
+	unsigned int 	m_SectorSizeInBytes = 0;
+	unsigned int 	m_SectorsPerCluster = 0;
+	unsigned int 	m_FatAddress = 0;
+	unsigned int 	m_RootDirectoryAddress = 0;
+	unsigned int 	m_RootDirectoryNumEntries = 0;
+	unsigned int 	m_DataAddress = 0; // the address of cluster 2, the first data cluster
+};
+
+struct Fat16Extent
+{
+	uint16_t 	m_StartingCluster;
+	uint16_t 	m_NumClusters; // contiguous clusters starting at m_StartingCluster
+};
+
+class Fat16SectorStream
+{
+	public:
+		Fat16SectorStream (IStorageMedia& storageMedia, const Fat16Geometry& geometry, unsigned int startingCluster,
+					unsigned int fileSizeInBytes);
+		~Fat16SectorStream();
+
+		unsigned int getSectorSizeInBytes() const { return m_Geometry.m_SectorSizeInBytes; }
+		unsigned int getStartingAddress() const; // the byte address of the file's first sector
+
+		// the number of sectors at the start of the file to skip on every rewind, such as a header
+		void setDataOffset (unsigned int numSectors);
+		unsigned int getDataSizeInBytes() const; // the file size without the skipped sectors
+
+		void rewind(); // return to the first sector of the file after the data offset
+		bool isFinished() const { return m_SectorsRead >= m_FileSizeInSectors; }
+
+		// finds at most maxSectors sectors that can be fetched with a single read, stopping early at the end of a contiguous
+		// run of clusters or the end of the file, returns the number of sectors and sets the byte address to read them from
+		// note: the stream must not be finished and maxSectors must be at least 1, call advance once the read is submitted
+		unsigned int nextSectorRun (unsigned int maxSectors, unsigned int& byteAddress);
+		void advance (unsigned int numSectors);
+
+		// walks the cluster chain once and keeps it as extents, returns false and keeps walking the chain if it is broken
+		// note: copies of the stream share the extent map
+		bool buildExtentMap (IAllocator* allocator = nullptr);
+		unsigned int getNumExtents() const { return m_NumExtents; }
+
+		// the layout of the file manager's active partition, invalid if it doesn't have a valid fat16 file system
+		static Fat16Geometry GetGeometry (IStorageMedia& storageMedia, Fat16FileManager& fileManager);
+
+		// returns the starting cluster of the entry with the given raw name and extension in a directory, or 0 if not found
+		// note: a directoryCluster of 0 is the root directory
+		static unsigned int FindStartingCluster (IStorageMedia& storageMedia, const Fat16Geometry& geometry,
+								unsigned int directoryCluster, const char* filenameRaw,
+								const char* extensionRaw);
+
+	private:
+		IStorageMedia* 		m_StorageMedia;
+		Fat16Geometry 		m_Geometry;
+
+		unsigned int 		m_StartingCluster;
+		unsigned int 		m_FileSizeInBytes;
+		unsigned int 		m_FileSizeInSectors;
+		unsigned int 		m_DataOffsetInSectors;
+
+		unsigned int 		m_CurrentCluster;
+		unsigned int 		m_SectorInCluster;
+		unsigned int 		m_SectorsRead;
+
+		SharedData<uint8_t> 	m_FatSectorCache; // the last sector of the file allocation table read
+		unsigned int 		m_FatSectorCacheNum;
+
+		SharedData<Fat16Extent> m_Extents;
+		unsigned int 		m_NumExtents; // 0 if there is no extent map
+		unsigned int 		m_CurrentExtent;
+		unsigned int 		m_ClusterInExtent;
+
+		unsigned int getNextCluster (unsigned int cluster);
+		unsigned int followChain(); // moves to the file's next cluster, using the extent map if there is one
+		unsigned int getFileSizeInClusters() const;
+
+		static unsigned int FindStartingClusterInSector (SharedData<uint8_t>& sector, unsigned int sectorSizeInBytes,
+									const char* filenameRaw, const char* extensionRaw,
+									bool& endOfDirectory);
+};
+
+#endif // FAT16SECTORSTREAM_HPP
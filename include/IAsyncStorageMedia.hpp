@@ -0,0 +1,37 @@
+#ifndef IASYNCSTORAGEMEDIA_HPP
+#define IASYNCSTORAGEMEDIA_HPP
+
+/*******************************************************************
+ * An IAsyncStorageMedia specifies a submit/poll interface for
+ * reading from storage. A read is submitted with the destination
+ * it should land in, and the caller is free to do other work
+ * (decoding, mixing) until polling the returned request id shows
+ * the read as complete. Implementations may complete reads
+ * immediately (see BlockingStorageMedia), on worker threads
+ * (see ThreadedStorageMedia), or from a dma interrupt.
+ *
+ * Note: The destination must stay valid until the read has been
+ * polled as complete or waited on, after which the request id is
+ * released and must not be polled again.
+*******************************************************************/
+
+#include <stdint.h>
+
+constexpr unsigned int ASYNC_STORAGE_MAX_REQUESTS = 16;
+constexpr unsigned int ASYNC_STORAGE_INVALID_REQUEST = ASYNC_STORAGE_MAX_REQUESTS;
+
+class IAsyncStorageMedia
+{
+	public:
+		virtual ~IAsyncStorageMedia() {}
+
+		// returns the request id, or ASYNC_STORAGE_INVALID_REQUEST if all request slots are in use
+		virtual unsigned int submitRead (uint8_t* destination, unsigned int sizeInBytes, unsigned int byteAddress) = 0;
+
+		// returns true once the read has landed in its destination, releasing the request id
+		virtual bool pollRead (unsigned int requestId) = 0;
+
+		virtual void waitForRead (unsigned int requestId) { while ( ! this->pollRead(requestId) ) {} }
+};
+
+#endif // IASYNCSTORAGEMEDIA_HPP
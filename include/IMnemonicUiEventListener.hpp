@@ -9,6 +9,7 @@
 
 #include "IEventListener.hpp"
 #include "Fat16Entry.hpp"
+#include "MnemonicConstants.hpp"
 
 enum class UiEventType : unsigned int
 {
@@ -22,7 +23,8 @@ enum class UiEventType : unsigned int
 	MIDI_TRACK_RECORDING_STATUS,
 	MIDI_TRACK_NOT_SAVED, // for when unable to save a scene because MIDI track isn't saved
 	SCENE_SAVING_STATUS,
-	SCENE_TRACK_FILE_LOADED // for when an audio file or midi file are loaded from a scene file
+	SCENE_TRACK_FILE_LOADED, // for when an audio file or midi file are loaded from a scene file
+	STREAM_TELEMETRY // periodic audio track streaming health, the data being a UiStreamTelemetry
 };
 
 struct UiFileExplorerEntry
@@ -31,6 +33,28 @@ struct UiFileExplorerEntry
 	unsigned int 	m_Index; // the index in the directory
 };
 
+struct UiStreamTrackTelemetry
+{
+	unsigned int 	m_CellX;
+	unsigned int 	m_CellY;
+	unsigned int 	m_NumUnderruns; // blocks the track went silent for while it still had file left to stream
+	unsigned int 	m_MinBlocksBuffered; // the ring's low-water mark, max unsigned int if it hasn't streamed yet
+	unsigned int 	m_RingDepth; // in ring units (see AudioTrack)
+	bool 		m_IsResident;
+};
+
+struct UiStreamTelemetry
+{
+	// bucket 0 counts reads that landed within the block they were submitted in, bucket n those that took 2^(n-1) to 2^n - 1
+	// blocks, and the last bucket everything slower
+	unsigned int 		m_ReadLatencyHistogram[MNEMONIC_SD_LATENCY_HISTOGRAM_BUCKETS];
+	unsigned int 		m_NumReads;
+	unsigned int 		m_WorstReadLatencyInBlocks;
+	unsigned int 		m_NumUnderruns; // across the loaded tracks
+	unsigned int 		m_NumTracks;
+	UiStreamTrackTelemetry 	m_Tracks[MNEMONIC_NEOTRELLIS_ROWS * MNEMONIC_NEOTRELLIS_COLS];
+};
+
 class MnemonicUiEvent : public IEvent
 {
 	public:
@@ -0,0 +1,25 @@
+#ifndef IREADINTOSTORAGEMEDIA_HPP
+#define IREADINTOSTORAGEMEDIA_HPP
+
+/*******************************************************************
+ * An IReadIntoStorageMedia reads straight into a buffer owned by
+ * the caller, rather than handing back a SharedData of its own the
+ * way IStorageMedia::readFromMedia does. A storage driver that
+ * implements it lets BlockingStorageMedia land each read in the
+ * audio track's ring without a temporary buffer or a copy.
+ *
+ * Note: The sd card driver lives in the hal, so this is the
+ * interface it needs to implement for the target to skip the copy.
+*******************************************************************/
+
+#include <stdint.h>
+
+class IReadIntoStorageMedia
+{
+	public:
+		virtual ~IReadIntoStorageMedia() {}
+
+		virtual void readFromMediaInto (uint8_t* destination, unsigned int sizeInBytes, unsigned int address) = 0;
+};
+
+#endif // IREADINTOSTORAGEMEDIA_HPP
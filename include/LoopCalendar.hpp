@@ -0,0 +1,56 @@
+#ifndef LOOPCALENDAR_HPP
+#define LOOPCALENDAR_HPP
+
+/*************************************************************************
+ * A LoopCalendar is the timeline of upcoming loop boundaries, the blocks
+ * at which a track waiting to start, stop or restart its loop has to be
+ * looked at. Each boundary names its track by type and index, and the
+ * owner pops whatever is due at the start of each block and schedules
+ * that track's next boundary, so a block without a boundary costs a
+ * single comparison however many tracks are loaded.
+ *
+ * Note: Blocks are counted by a free running counter owned by the
+ * caller rather than the master clock, so boundaries after the master
+ * clock wraps still sort after the ones before it. The calendar holds
+ * at most MNEMONIC_LOOP_CALENDAR_SIZE boundaries, kept sorted latest
+ * first so that popping is constant time, and indices are invalidated
+ * by loading or unloading tracks, so it should be rebuilt then.
+*************************************************************************/
+
+#include "MnemonicConstants.hpp"
+#include <stdint.h>
+
+enum class LoopTrackType : unsigned int
+{
+	AUDIO = 0,
+	MIDI = 1
+};
+
+struct LoopBoundary
+{
+	uint32_t 	m_Block;
+	LoopTrackType 	m_TrackType;
+	unsigned int 	m_TrackIndex;
+};
+
+class LoopCalendar
+{
+	public:
+		LoopCalendar();
+		~LoopCalendar();
+
+		void clear() { m_NumBoundaries = 0; }
+		unsigned int getNumBoundaries() const { return m_NumBoundaries; }
+
+		// returns false if the calendar is full
+		bool schedule (const uint32_t block, const LoopTrackType trackType, const unsigned int trackIndex);
+
+		// pops the earliest boundary if it is due by the given block, returns false if none are
+		bool popDue (const uint32_t block, LoopBoundary& boundary);
+
+	private:
+		LoopBoundary 	m_Boundaries[MNEMONIC_LOOP_CALENDAR_SIZE]; // latest first
+		unsigned int 	m_NumBoundaries;
+};
+
+#endif // LOOPCALENDAR_HPP
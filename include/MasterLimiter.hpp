@@ -0,0 +1,55 @@
+#ifndef MASTERLIMITER_HPP
+#define MASTERLIMITER_HPP
+
+/*************************************************************************
+ * The MasterLimiter takes the int32 mix bus and limits it to the dac's
+ * range with a short lookahead, so dense scenes duck instead of wrapping
+ * around. The block is split into segments of MASTER_LIMITER_LOOKAHEAD
+ * samples. The stereo linked peak of each segment sets a target gain for
+ * the end of the segment before it, and the gain ramps linearly between
+ * segment boundaries, so the gain is already low enough by the time a
+ * peak comes out of the lookahead delay. Rising gain is smoothed so that
+ * the limiter releases over a few tens of milliseconds.
+ *
+ * Note: The cost per block is fixed, one pass to find the segment peaks,
+ * one division per segment and one multiply per sample per channel. The
+ * output is delayed by MASTER_LIMITER_LOOKAHEAD samples.
+*************************************************************************/
+
+#include "AudioConstants.hpp"
+#include <stdint.h>
+
+constexpr unsigned int MASTER_LIMITER_LOOKAHEAD = 32; // in samples, must be a power of two
+constexpr unsigned int MASTER_LIMITER_LOOKAHEAD_SHIFT = 5;
+constexpr unsigned int MASTER_LIMITER_RELEASE_SHIFT = 5; // each segment closes 1/32nd of the gap to the target when releasing
+constexpr int32_t MASTER_LIMITER_THRESHOLD = ( 4096 / 2 ) - 1; // the peak of the 12-bit dac, centred around 0
+constexpr int32_t MASTER_LIMITER_UNITY_GAIN = 1 << 16;
+
+static_assert( (1 << MASTER_LIMITER_LOOKAHEAD_SHIFT) == MASTER_LIMITER_LOOKAHEAD, "lookahead shift must match lookahead" );
+static_assert( ABUFFER_SIZE % MASTER_LIMITER_LOOKAHEAD == 0, "audio blocks must be a whole number of limiter segments" );
+
+class MasterLimiter
+{
+	public:
+		MasterLimiter();
+		~MasterLimiter();
+
+		// limits the mix bus and adds the result to the output buffers, both are ABUFFER_SIZE samples long
+		void process (const int32_t* mixBusL, const int32_t* mixBusR, int16_t* writeBufferL, int16_t* writeBufferR);
+
+		void reset();
+
+		int32_t getGain() const { return m_Gain; } // the current gain, unity being MASTER_LIMITER_UNITY_GAIN
+
+	private:
+		int32_t 	m_DelayL[MASTER_LIMITER_LOOKAHEAD]; // the last segment of the previous block
+		int32_t 	m_DelayR[MASTER_LIMITER_LOOKAHEAD];
+		int32_t 	m_DelayPeak;
+
+		int32_t 	m_Gain; // the gain at the start of the next segment
+
+		int32_t targetGainForPeak (const int32_t peak) const;
+		void processSegment (const int32_t* inL, const int32_t* inR, int16_t* outL, int16_t* outR, const int32_t targetGain);
+};
+
+#endif // MASTERLIMITER_HPP
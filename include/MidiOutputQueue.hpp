@@ -0,0 +1,50 @@
+#ifndef MIDIOUTPUTQUEUE_HPP
+#define MIDIOUTPUTQUEUE_HPP
+
+/*************************************************************************
+ * A MidiOutputQueue holds the bytes waiting to go out over the midi
+ * wire, so that whoever produces midi never waits on the wire. Events
+ * are written into it whole, and the transmitter reads a byte each time
+ * the wire is ready for one, such as from the usart's transmit empty
+ * interrupt on the target (see WireRateMidiOutputQueue for host).
+ *
+ * Channel messages are written with running status, leaving out the
+ * status byte when it's the same as the last one written, which saves a
+ * third of the bytes of runs of notes or controllers on one channel. The
+ * status is written again after the queue runs dry, so a receiver that
+ * missed it picks it back up at the next gap.
+ *
+ * Note: There is one writing and one reading context. Transmitters that
+ * go idle when the queue runs dry override onBytesWritten to wake back
+ * up, it is called in the writing context after every event written.
+*************************************************************************/
+
+#include "IMidiEventListener.hpp"
+#include "SpscRing.hpp"
+#include <stdint.h>
+
+constexpr unsigned int MIDI_OUTPUT_QUEUE_SIZE = 256; // in bytes, about 80ms of the wire at 31250 baud, a power of two
+
+class MidiOutputQueue
+{
+	public:
+		MidiOutputQueue();
+		virtual ~MidiOutputQueue();
+
+		// returns false and writes nothing if there isn't room for all of the event's bytes
+		bool writeEvent (const MidiEvent& midiEvent);
+
+		bool readByte (uint8_t& byte) { return m_Bytes.pop( byte ); }
+		bool isEmpty() const { return m_Bytes.isEmpty(); }
+		unsigned int getNumBytesQueued() const { return m_Bytes.size(); }
+
+	protected:
+		virtual void onBytesWritten() {}
+
+	private:
+		SpscRing<uint8_t, MIDI_OUTPUT_QUEUE_SIZE> 	m_Bytes;
+
+		uint8_t 					m_RunningStatus; // the writing context's last channel status written, 0 if none
+};
+
+#endif // MIDIOUTPUTQUEUE_HPP
@@ -0,0 +1,61 @@
+#ifndef MIDIOUTPUTSCHEDULER_HPP
+#define MIDIOUTPUTSCHEDULER_HPP
+
+/*************************************************************************
+ * The MidiOutputScheduler holds timed midi events until the sample they
+ * are due at, so that the events of a block go out spread across the
+ * block as they were recorded instead of in one burst at its start. The
+ * main loop schedules the events the audio manager produced, and the
+ * audio output interrupt calls release with the MidiSampleClock's count
+ * after each sample, which writes the events that are due to the midi
+ * output queue.
+ *
+ * Note offs go ahead of the other events due at the same sample, and
+ * when the wire falls behind they go ahead of the other events that are
+ * overdue too, so notes keep stopping on time when the wire saturates.
+ * A note off never goes ahead of a note on or off for the same note, or
+ * of another note off.
+ *
+ * Note: schedule and release may run in different contexts, since only
+ * release touches the pending events. Otherwise events due at the same
+ * sample keep the order they were scheduled in, events scheduled for a
+ * time that has already passed are released right away, and due events
+ * wait for the wire to catch up while the output queue is backed up.
+*************************************************************************/
+
+#include "MidiTrack.hpp"
+#include "SpscRing.hpp"
+#include <stdint.h>
+
+class MidiOutputQueue;
+
+constexpr unsigned int MIDI_OUTPUT_SCHEDULER_SIZE = 64; // events that can be scheduled or pending at once, a power of two
+// due events wait here rather than in the output queue while it has this many bytes, about 4ms of the wire, so that there
+// is still a choice of what goes next when the wire falls behind
+constexpr unsigned int MIDI_OUTPUT_SCHEDULER_MAX_BYTES_QUEUED = 12;
+
+class MidiOutputScheduler
+{
+	public:
+		MidiOutputScheduler();
+		~MidiOutputScheduler();
+
+		bool schedule (const TimedMidiEvent& timedMidiEvent); // returns false and drops the event if too many are scheduled
+
+		void release (uint32_t sampleTime, MidiOutputQueue& outputQueue); // sampleTime is the sample clock's count now
+
+		unsigned int getNumDropped() const { return m_NumDropped; }
+
+	private:
+		SpscRing<TimedMidiEvent, MIDI_OUTPUT_SCHEDULER_SIZE> 	m_Scheduled;
+
+		// the release context's events not yet due, latest first so the next one due is always at the end
+		TimedMidiEvent 						m_Pending[MIDI_OUTPUT_SCHEDULER_SIZE];
+		unsigned int 						m_NumPending;
+
+		unsigned int 						m_NumDropped;
+
+		void addPending (const TimedMidiEvent& timedMidiEvent);
+};
+
+#endif // MIDIOUTPUTSCHEDULER_HPP
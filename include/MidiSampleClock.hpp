@@ -0,0 +1,62 @@
+#ifndef MIDISAMPLECLOCK_HPP
+#define MIDISAMPLECLOCK_HPP
+
+/*************************************************************************
+ * The MidiSampleClock counts the samples sent to the dac, so that midi
+ * can be timed to the sample instead of to the audio block. The audio
+ * output interrupt ticks it once per sample, and the midi receive
+ * interrupt hands it every byte before the midi handler gets it, so
+ * each channel message is stamped with the sample count at its first
+ * byte. When the midi handler dispatches the message, the audio manager
+ * pops the matching timestamp.
+ *
+ * Note: Ticking must start with the first sample of the audio buffer,
+ * so that the clock's multiples of ABUFFER_SIZE are where the dac moves
+ * from one block to the next. Timestamps are matched to dispatched
+ * events by status byte, and the ones for messages the midi handler
+ * didn't dispatch are skipped over. Only channel messages are stamped.
+*************************************************************************/
+
+#include "SpscRing.hpp"
+#include <atomic>
+#include <stdint.h>
+
+constexpr unsigned int MIDI_SAMPLE_CLOCK_NUM_TIMESTAMPS = 32; // messages received and not yet dispatched, a power of two
+
+struct MidiTimestamp
+{
+	uint8_t 	m_Status;
+	uint32_t 	m_SampleCount;
+};
+
+class MidiSampleClock
+{
+	public:
+		MidiSampleClock();
+		~MidiSampleClock();
+
+		// the audio output context, once per sample or with the number of samples sent
+		void tick (unsigned int numSamples = 1)
+		{
+			m_SampleCount.store( m_SampleCount.load(std::memory_order_relaxed) + numSamples, std::memory_order_release );
+		}
+		uint32_t getSampleCount() const { return m_SampleCount.load( std::memory_order_acquire ); }
+
+		// the midi receive context, with every byte as it arrives
+		void onByteReceived (uint8_t byte);
+
+		// the midi dispatch context, returns false if there is no timestamp for a message with this status
+		bool popTimestamp (uint8_t status, uint32_t& sampleCount);
+
+	private:
+		std::atomic<uint32_t> 					m_SampleCount;
+
+		SpscRing<MidiTimestamp, MIDI_SAMPLE_CLOCK_NUM_TIMESTAMPS> 	m_Timestamps;
+
+		// the receive context's view of the message in progress
+		uint8_t 						m_RunningStatus; // 0 if there isn't one
+		unsigned int 						m_DataBytesLeft;
+		uint32_t 						m_MessageStart;
+};
+
+#endif // MIDISAMPLECLOCK_HPP
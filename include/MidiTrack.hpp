@@ -3,22 +3,49 @@
 
 /*************************************************************************
  * A MidiTrack defines a stream of midi events with time codes to be
- * played in a loop.
+ * played in a loop. Each event's time code is the block it was recorded
+ * in, with the sample in that block it arrived at.
+ *
+ * Note: When the track is created its events are ordered by time code
+ * and an offset table is built with the first event of every block in
+ * the loop, so playing a block copies that block's events straight out
+ * without searching. Events past the loop end are never played, and
+ * only the first MIDI_TRACK_MAX_INDEXED_EVENTS are indexed.
 *************************************************************************/
 
 #include "IMidiEventListener.hpp"
 #include "SharedData.hpp"
 #include "Fat16Entry.hpp"
-#include <vector>
+#include "AudioConstants.hpp"
+#include "MnemonicConstants.hpp"
+#include "SpscRing.hpp"
+#include <stdint.h>
 
 class IAllocator;
 
+constexpr unsigned int MIDI_TRACK_MAX_INDEXED_EVENTS = UINT16_MAX; // the block offsets are 16-bit to keep the table small
+// the time code and sample offset share what used to be the time code, so that files saved before offsets load with offsets of 0
+constexpr unsigned int MIDI_TRACK_SAMPLE_OFFSET_BITS = 10;
+constexpr unsigned int MIDI_TRACK_TIME_CODE_BITS = 32 - MIDI_TRACK_SAMPLE_OFFSET_BITS; // about 15 hours of blocks
+
+static_assert( ABUFFER_SIZE <= (1 << MIDI_TRACK_SAMPLE_OFFSET_BITS), "a sample offset must fit in its bits" );
+
 struct MidiTrackEvent
 {
 	MidiEvent 	m_MidiEvent;
-	unsigned int 	m_TimeCode;
+	uint32_t 	m_TimeCode : MIDI_TRACK_TIME_CODE_BITS; // the block
+	uint32_t 	m_SampleOffset : MIDI_TRACK_SAMPLE_OFFSET_BITS; // the sample in the block
+};
+
+struct TimedMidiEvent
+{
+	MidiEvent 	m_MidiEvent;
+	uint32_t 	m_SampleTime; // the MidiSampleClock count to send the event at
 };
 
+// produced by the audio manager, taken by whatever sends midi out, which may run in another context
+typedef SpscRing<TimedMidiEvent, MNEMONIC_MIDI_EVENTS_TO_SEND_SIZE> MidiEventsToSend;
+
 class MidiTrack
 {
 	public:
@@ -48,7 +75,12 @@ class MidiTrack
 		bool justFinished() { const bool justFinished = m_JustFinished; m_JustFinished = false; return justFinished; }
 
 		bool waitForLoopStartOrEnd (const unsigned int timeCode); // returns true when just started
-		void addMidiEventsAtTimeCode (const unsigned int timeCode, std::vector<MidiEvent>& midiEventOutputVector);
+		// false if not waiting to start or stop, so the track doesn't need its loop boundaries checked
+		bool needsLoopBoundaries() const { return m_WaitToPlay || m_WaitToStop; }
+		// blockStartSampleTime is when the block with this time code starts playing, each event is timed by its offset from that,
+		// returns the number of events that didn't fit
+		unsigned int addMidiEventsAtTimeCode (const unsigned int timeCode, const uint32_t blockStartSampleTime,
+							MidiEventsToSend& midiEventsToSend);
 
 	private:
 		unsigned int 			m_CellX;
@@ -58,7 +90,7 @@ class MidiTrack
 		unsigned int 			m_LengthInMidiTrackEvents;
 		unsigned int 			m_LoopEndInBlocks;
 
-		unsigned int 			m_MidiTrackEventsIndex;
+		SharedData<uint16_t> 		m_BlockOffsets; // m_LoopEndInBlocks + 1 entries, the events of block n are [n, n + 1)
 
 		bool 				m_IsSaved; // whether or not the midi file is saved in the file system
 		char 				m_FilenameDisplay[FAT16_FILENAME_SIZE + FAT16_EXTENSION_SIZE + 2];
@@ -71,6 +103,9 @@ class MidiTrack
 		bool 				m_JustFinished;
 
 		bool 				m_LoopWaitForZero; // only start/stop looping if master clock = 0
+
+		// orders the events by block, then fills in the block offsets
+		void buildBlockOffsets (const MidiTrackEvent* const midiTrackEvents, IAllocator& allocator);
 };
 
 #endif // MIDITRACK_HPP
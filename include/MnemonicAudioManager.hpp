@@ -13,10 +13,17 @@
 #include "IBufferCallback.hpp"
 #include "IMidiEventListener.hpp"
 #include "Fat16FileManager.hpp"
+#include "Fat16DirectoryIndex.hpp"
 #include "IMnemonicParameterEventListener.hpp"
 #include "IAllocator.hpp"
+#include "BlockingStorageMedia.hpp"
+#include "MasterLimiter.hpp"
+#include "IMnemonicUiEventListener.hpp"
+#include "LoopCalendar.hpp"
 
 class IStorageMedia;
+class IReadIntoStorageMedia;
+class MidiSampleClock;
 
 enum class MidiRecordingState : unsigned int
 {
@@ -34,43 +41,90 @@ enum class Directory : unsigned int
 	SCENE = 3
 };
 
+constexpr unsigned int MNEMONIC_NUM_DIRECTORIES = 4;
+
+// the files shown by the file explorer for one directory, kept in directory order in axi sram
+struct FileExplorerListing
+{
+	UiFileExplorerEntry* 	m_Entries = nullptr;
+	unsigned int 		m_NumEntries = 0;
+	unsigned int 		m_Capacity = 0;
+};
+
 class MnemonicAudioManager : public IBufferCallback<int16_t, true>, public IMnemonicParameterEventListener, public IMidiEventListener
 {
 	public:
-		MnemonicAudioManager (IStorageMedia& sdCard, uint8_t* axiSramPtr, unsigned int axiSramSizeInBytes);
+		// audio tracks stream through asyncSdCard if given, otherwise through blocking reads of sdCard, which land straight in
+		// the track's ring if readIntoSdCard is given as well
+		MnemonicAudioManager (IStorageMedia& sdCard, uint8_t* axiSramPtr, unsigned int axiSramSizeInBytes,
+					IAsyncStorageMedia* asyncSdCard = nullptr, IReadIntoStorageMedia* readIntoSdCard = nullptr);
 		~MnemonicAudioManager() override;
 
 		void publishUiEvents(); // updates the periodic ui events
 
 		void verifyFileSystem(); // should be called on boot up at the very least
 
+		// one-shots loaded while they fit in this budget play from memory, the rest stream as usual
+		void setOneshotCacheBudget (unsigned int budgetInBytes) { m_OneshotCacheBudgetInBytes = budgetInBytes; }
+
+		// the rate call is driven at, audio files recorded at other rates are resampled to it, only affects files loaded later
+		void setSampleRate (unsigned int sampleRate) { m_SampleRate = sampleRate; }
+		unsigned int getSampleRate() const { return m_SampleRate; }
+
 		void call (int16_t* writeBufferL, int16_t* writeBufferR) override;
 
 		void onMnemonicParameterEvent (const MnemonicParameterEvent& paramEvent) override;
 
+		// the clock counting the samples sent to the dac, without one midi is only timed to the block
+		void setMidiSampleClock (MidiSampleClock* midiSampleClock) { m_MidiSampleClock = midiSampleClock; }
+
 		void onMidiEvent (const MidiEvent& midiEvent) override;
-		std::vector<MidiEvent>& getMidiEventsToSendVec() { return m_MidiEventsToSend; }
+		// onMidiEvent and call are the producer, so they must run in the same context
+		MidiEventsToSend& getMidiEventsToSend() { return m_MidiEventsToSend; }
+		unsigned int getNumMidiEventsDropped() const { return m_NumMidiEventsDropped; } // since boot, because the output fell behind
 
 	private:
 		IAllocator 			m_AxiSramAllocator;
 		Fat16FileManager 		m_FileManager;
 
+		IStorageMedia& 			m_SdCard; // audio tracks stream from here directly instead of through the file manager
+		BlockingStorageMedia 		m_BlockingSdCard;
+		IAsyncStorageMedia* 		m_AsyncSdCard;
+		Fat16Geometry 			m_Fat16Geometry;
+		unsigned int 			m_AudioDirectoryCluster;
+
 		Directory 			m_CurrentDirectory;
+		Fat16DirectoryIndex 		m_DirectoryIndices[MNEMONIC_NUM_DIRECTORIES]; // indexed by Directory, built in verifyFileSystem
+		FileExplorerListing 		m_FileExplorerListings[MNEMONIC_NUM_DIRECTORIES]; // also kept up to date by createEntry/deleteEntry
 
 		unsigned int 			m_TransportProgress;
 
 		std::vector<AudioTrack> 	m_AudioTracks;
+		unsigned int 			m_AudioTrackRingBudgetInBytes; // shared between the ring buffers of all audio tracks
+		unsigned int 			m_WorstSdLatencyInBlocks; // the slowest read seen so far, in audio blocks
+		unsigned int 			m_OneshotCacheBudgetInBytes; // shared between resident one-shot tracks
+		UiStreamTelemetry 		m_StreamTelemetry; // the reads are recorded as they land, the tracks filled in on publish
+		unsigned int 			m_StreamTelemetryBlockCount; // audio blocks since the telemetry was last published
 
-		uint16_t* 			m_DecompressedBuffer; // for holding decompressed audio buffers for all audio tracks
+		unsigned int 			m_SampleRate; // MNEMONIC_SAMPLE_RATE on target
+		int32_t 			m_MixBusL[ABUFFER_SIZE]; // audio tracks are summed here before limiting
+		int32_t 			m_MixBusR[ABUFFER_SIZE];
+		MasterLimiter 			m_MasterLimiter;
 
 		unsigned int 			m_MasterClockCount;
 		unsigned int 			m_CurrentMaxLoopCount; // master clock resets after reaching this amount
+		LoopCalendar 			m_LoopCalendar; // the upcoming loop boundaries of the tracks waiting on one
+		uint32_t 			m_LoopCalendarBlockCount; // free running, the calendar's time
+		bool 				m_LoopingInfoChanged; // a track started or stopped, so the max loop count is recomputed
 
 		unsigned int 			m_ActiveMidiChannel;
 
 		std::vector<MidiTrack> 		m_MidiTracks;
 
-		std::vector<MidiEvent> 		m_MidiEventsToSend; // a vector of all midi events at a time code to be sent over usart
+		MidiEventsToSend 		m_MidiEventsToSend; // all midi events to be sent over usart
+		unsigned int 			m_NumMidiEventsDropped;
+		MidiSampleClock* 		m_MidiSampleClock;
+		uint32_t 			m_BlockStartSampleTime; // the sample clock's count when the block from the last call starts playing
 
 		MidiRecordingState 		m_RecordingMidiState;
 		MidiTrackEvent* const		m_TempMidiTrackEvents;
@@ -80,11 +134,32 @@ class MnemonicAudioManager : public IBufferCallback<int16_t, true>, public IMnem
 		unsigned int 			m_TempMidiTrackCellX;
 		unsigned int 			m_TempMidiTrackCellY;
 
-		void resetLoopingInfo();
+		void resetLoopingInfo(); // recomputes the max loop count, rebuilding the loop calendar if it changed
+
+		// should be called whenever a track is loaded, unloaded, played or stopped
+		void rebuildLoopCalendar();
+		void scheduleLoopBoundary (const LoopTrackType trackType, const unsigned int trackIndex);
+		void handleLoopBoundary (const LoopBoundary& boundary);
+
+		// where a sample clock time falls in the block from the last call, for recording midi
+		unsigned int getSampleOffsetInBlock (uint32_t sampleTime) const;
+
+		void streamAudioTracks(); // refills audio track buffers, most urgent (closest to underrunning) first
+		void recordReadLatency (unsigned int readLatencyInBlocks);
+		void publishStreamTelemetry();
+		void resizeAudioTrackRings(); // shares the ring budget between loaded tracks, should be called on load and unload
+		unsigned int getAudioTrackRingSizeWanted (const AudioTrack& audioTrack) const; // in bytes, before the budget is shared
+		// makes the tracks resident if they all fit in what's left of the budget, so both halves of a stereo pair start together
+		void cacheOneshotTracks (unsigned int firstTrackIndex, unsigned int numTracks);
 
 		void playOrStopTrack (unsigned int cellX, unsigned int cellY, bool play);
 
 		bool goToDirectory (const Directory& directory); // returns false if directory not found, true if successful
+		Fat16DirectoryIndex& getDirectoryIndex (const Directory& directory);
+
+		// entries in the current directory should only be created and deleted through these, to keep its index up to date
+		bool createEntry (Fat16Entry& entry);
+		void deleteEntry (unsigned int index);
 
 		void loadFile (unsigned int cellX, unsigned int cellY, unsigned int index);
 		void unloadFile (unsigned int cellX, unsigned int cellY);
@@ -96,8 +171,10 @@ class MnemonicAudioManager : public IBufferCallback<int16_t, true>, public IMnem
 
 		void saveScene (const char* nameWithoutExt);
 
-		uint8_t* enterFileExplorerHelper (const char* extension, unsigned int& numEntries, uint8_t* previousPtr);
 		void enterFileExplorer (const Directory& dir);
+		void buildFileExplorerListing (const Directory& dir); // lists the current directory, which should be dir
+		void addToFileExplorerListing (const Directory& dir, const Fat16Entry& entry, unsigned int index);
+		void removeFromFileExplorerListing (const Directory& dir, unsigned int index);
 
 		bool loadSceneFileHelper (const std::string& versionStr, std::string& sceneStr);
 		bool loadAudioFileHelper (const std::string& filename, unsigned int cellX, unsigned int cellY);
@@ -106,6 +183,8 @@ class MnemonicAudioManager : public IBufferCallback<int16_t, true>, public IMnem
 		bool loadMidiFileHelper (unsigned int index, unsigned int cellX, unsigned int cellY);
 
 		Fat16Entry* lookForOtherChannel (const char* filenameDisplay); // for looking for other stereo channel
+		// skips the header of interleaved stereo files, returns false if the file is a b12 variant this build can't play
+		bool readB12ContainerHeader (Fat16SectorStream& stream, unsigned int& numChannels, unsigned int& sampleRate);
 };
 
 #endif // MNEMONICAUDIOMANAGER_HPP
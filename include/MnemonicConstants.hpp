@@ -28,14 +28,28 @@ enum class MNEMONIC_ROW : unsigned int
 	MIDI_CHAN_4_LOOPS = 7,
 };
 
+constexpr unsigned int MNEMONIC_SAMPLE_RATE = 40000; // the dac timer rate, each audio block must be ready within ABUFFER_SIZE samples of it
+
 constexpr unsigned int MNEMONIC_NEOTRELLIS_ROWS = 8;
 constexpr unsigned int MNEMONIC_NEOTRELLIS_COLS = 8;
 
 constexpr unsigned int MNEMONIC_MAX_MIDI_TRACK_EVENTS = 1000; // the max number of midi events able to record for a midi track
+constexpr unsigned int MNEMONIC_MIDI_EVENTS_TO_SEND_SIZE = 128; // midi events produced and not yet taken by the midi output, a power of two
+
+constexpr unsigned int MNEMONIC_MAX_SECTOR_READS_PER_BLOCK = 24; // the streaming time budget, in sd card sector reads per audio block
+constexpr unsigned int MNEMONIC_AUDIO_RING_SRAM_DIVISOR = 4; // a quarter of the axi sram is shared between audio track ring buffers
+constexpr unsigned int MNEMONIC_MAX_AUDIO_RING_UNITS = 8; // ring depth cap unless measured sd latency asks for more
+constexpr unsigned int MNEMONIC_LOOP_HEAD_RING_UNITS = 1; // the start of each loop kept in memory, so loop restarts don't wait on the sd card
+constexpr unsigned int MNEMONIC_ONESHOT_CACHE_SRAM_DIVISOR = 4; // a quarter of the axi sram may hold one-shots resident in memory
+constexpr unsigned int MNEMONIC_SD_LATENCY_HISTOGRAM_BUCKETS = 8; // 0, 1, 2-3, 4-7 ... 64+ audio blocks per read
+constexpr unsigned int MNEMONIC_STREAM_TELEMETRY_PERIOD_IN_BLOCKS = 64; // how often the streaming telemetry ui event is published
+constexpr unsigned int MNEMONIC_LOOP_CALENDAR_SIZE = MNEMONIC_NEOTRELLIS_ROWS * MNEMONIC_NEOTRELLIS_COLS * 2; // every cell, stereo pairs too
 
 constexpr unsigned int MNEMONIC_POT_STABIL_NUM = 50; // pot stabilization stuff
 constexpr float MNEMONIC_POT_MENU_CHANGE_THRESH = 0.5f; // threshold to break for a status submenu change
 
+constexpr unsigned int MNEMONIC_FILE_EXPLORER_SPARE_ENTRIES = 8; // room to add files to a listing before it is reallocated
+
 constexpr unsigned int MNEMONIC_PARAMETER_EVENT_QUEUE_SIZE = 1000;
 constexpr unsigned int MNEMONIC_UI_EVENT_QUEUE_SIZE = 10;
 
@@ -0,0 +1,109 @@
+#ifndef MNEMONICPROFILER_HPP
+#define MNEMONICPROFILER_HPP
+
+/*************************************************************************
+ * The MnemonicProfiler times scopes of the audio path and keeps the
+ * min, average and max cost of each scope per audio block. Scopes that
+ * run several times in a block, such as one per audio track, are summed
+ * for the block. On the target the ticks are core cycles read from the
+ * DWT cycle counter, on the host they are nanoseconds read from a
+ * monotonic clock. The worst block of each scope can be reported as a
+ * percentage of the block deadline, ABUFFER_SIZE samples at
+ * MNEMONIC_SAMPLE_RATE.
+ *
+ * Note: Everything compiles to nothing unless MNEMONIC_PROFILING is
+ * defined, so the audio path should only use the MNEMONIC_PROFILE_BLOCK
+ * and MNEMONIC_PROFILE_SCOPE macros. The block is ended when the
+ * MNEMONIC_PROFILE_BLOCK scope closes, which should be the outermost.
+*************************************************************************/
+
+#include <stdint.h>
+
+enum class ProfileScope : unsigned int
+{
+	AUDIO_MANAGER_CALL,
+	AUDIO_TRACK_CALL,
+	B12_DECODE_MIX,
+	RESAMPLE, 		// PolyphaseResampler::process
+	MIDI_TRACK_EVENTS, 	// MidiTrack::addMidiEventsAtTimeCode
+	RESET_LOOPING_INFO,
+	NUM_SCOPES
+};
+
+constexpr unsigned int MNEMONIC_PROFILE_NUM_SCOPES = static_cast<unsigned int>( ProfileScope::NUM_SCOPES );
+
+struct ProfileStats
+{
+	uint32_t 	m_MinTicks;
+	uint32_t 	m_MaxTicks;
+	uint64_t 	m_TotalTicks;
+	uint32_t 	m_NumBlocks; // only blocks the scope ran in
+};
+
+#ifdef MNEMONIC_PROFILING
+
+class MnemonicProfiler
+{
+	public:
+		// starts the cycle counter on the target, where coreClockFrequency is needed to convert cycles to time
+		static void Enable (uint32_t coreClockFrequency);
+		static void Reset();
+
+		static uint32_t GetTicks();
+		static uint32_t GetTicksPerSecond() { return m_TicksPerSecond; }
+
+		static void AddToBlock (const ProfileScope scope, uint32_t ticks);
+		static void EndBlock(); // folds each scope's ticks for this block into its stats
+
+		static const ProfileStats& GetStats (const ProfileScope scope) { return m_Stats[static_cast<unsigned int>(scope)]; }
+		static uint32_t GetAverageTicks (const ProfileScope scope);
+		static float GetWorstBlockPercentOfDeadline (const ProfileScope scope);
+
+		static const char* GetScopeName (const ProfileScope scope);
+
+	private:
+		static uint32_t 	m_TicksPerSecond;
+		static ProfileStats 	m_Stats[MNEMONIC_PROFILE_NUM_SCOPES];
+		static uint32_t 	m_BlockTicks[MNEMONIC_PROFILE_NUM_SCOPES];
+		static bool 		m_RanThisBlock[MNEMONIC_PROFILE_NUM_SCOPES];
+};
+
+class ProfileScopeTimer
+{
+	public:
+		ProfileScopeTimer (const ProfileScope scope) : m_Scope( scope ), m_StartTicks( MnemonicProfiler::GetTicks() ) {}
+		~ProfileScopeTimer() { MnemonicProfiler::AddToBlock( m_Scope, MnemonicProfiler::GetTicks() - m_StartTicks ); }
+
+	private:
+		ProfileScope 	m_Scope;
+		uint32_t 	m_StartTicks;
+};
+
+class ProfileBlockTimer
+{
+	public:
+		ProfileBlockTimer (const ProfileScope scope) : m_Scope( scope ), m_StartTicks( MnemonicProfiler::GetTicks() ) {}
+		~ProfileBlockTimer()
+		{
+			MnemonicProfiler::AddToBlock( m_Scope, MnemonicProfiler::GetTicks() - m_StartTicks );
+			MnemonicProfiler::EndBlock();
+		}
+
+	private:
+		ProfileScope 	m_Scope;
+		uint32_t 	m_StartTicks;
+};
+
+#define MNEMONIC_PROFILE_CONCAT_INNER(a, b) a##b
+#define MNEMONIC_PROFILE_CONCAT(a, b) MNEMONIC_PROFILE_CONCAT_INNER( a, b )
+#define MNEMONIC_PROFILE_BLOCK(scope) ProfileBlockTimer MNEMONIC_PROFILE_CONCAT( profileBlockTimer, __LINE__ )( scope )
+#define MNEMONIC_PROFILE_SCOPE(scope) ProfileScopeTimer MNEMONIC_PROFILE_CONCAT( profileScopeTimer, __LINE__ )( scope )
+
+#else
+
+#define MNEMONIC_PROFILE_BLOCK(scope)
+#define MNEMONIC_PROFILE_SCOPE(scope)
+
+#endif // MNEMONIC_PROFILING
+
+#endif // MNEMONICPROFILER_HPP
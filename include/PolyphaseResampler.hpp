@@ -0,0 +1,71 @@
+#ifndef POLYPHASERESAMPLER_HPP
+#define POLYPHASERESAMPLER_HPP
+
+/*************************************************************************
+ * A PolyphaseResampler converts decoded audio from a source sample rate
+ * to the engine's output rate a block at a time, using only integer
+ * math. The source position is a 24-bit fraction and each output
+ * sample is an 8 tap windowed sinc filter, picked from a table of 64
+ * phases by the top bits of the fraction. The cutoff is lowered when
+ * downsampling so the source's top octave doesn't alias. The output
+ * is mixed straight into the int32 mix buses with the same q14 gains
+ * as B12DecodeMix.
+ *
+ * The owner pushes decoded source frames until getSourceFramesNeeded
+ * is 0 and then calls process, which consumes what the block used and
+ * keeps the rest for the next block.
+ *
+ * Note: The filter table and history are allocated by configure, and
+ * a resampler that isn't configured (or whose rates match) is inactive
+ * and shouldn't be used. Sources up to POLYPHASE_RESAMPLER_MAX_RATIO
+ * times the output rate are supported. Samples are expected to be in
+ * the 11-bit range that B12DecodeMix produces before its gains.
+*************************************************************************/
+
+#include "SharedData.hpp"
+#include <stdint.h>
+
+class IAllocator;
+
+constexpr unsigned int POLYPHASE_RESAMPLER_NUM_TAPS = 8;
+constexpr unsigned int POLYPHASE_RESAMPLER_PHASE_BITS = 6;
+constexpr unsigned int POLYPHASE_RESAMPLER_NUM_PHASES = 1 << POLYPHASE_RESAMPLER_PHASE_BITS;
+constexpr unsigned int POLYPHASE_RESAMPLER_FRACTION_BITS = 24;
+constexpr unsigned int POLYPHASE_RESAMPLER_MAX_RATIO = 2; // the source may be at most twice the output rate
+
+class PolyphaseResampler
+{
+	public:
+		PolyphaseResampler();
+		~PolyphaseResampler();
+
+		// returns false and stays inactive if the rates are equal or out of range, maxOutputFrames is the most process is asked
+		// for at once and maxPushFrames the most pushed at once past what getSourceFramesNeeded asks for
+		bool configure (unsigned int sourceRate, unsigned int outputRate, unsigned int numChannels, unsigned int maxOutputFrames,
+				unsigned int maxPushFrames, IAllocator* allocator = nullptr);
+		bool isActive() const { return m_Step != 0; }
+
+		void reset(); // forgets the history, for when the source restarts
+
+		// the number of source frames still to push before process can produce numOutputFrames
+		unsigned int getSourceFramesNeeded (unsigned int numOutputFrames) const;
+		// the average number of source frames per output frame, as a 24-bit fraction
+		uint32_t getStep() const { return m_Step; }
+
+		// frames are the int32 samples B12DecodeMix produces at unity gain, framesR is ignored for a single channel
+		void pushSourceFrames (const int32_t* framesL, const int32_t* framesR, unsigned int numFrames);
+		void process (unsigned int numOutputFrames, int32_t* busL, int32_t* busR, int16_t gainL, int16_t gainR);
+
+	private:
+		SharedData<int16_t> 	m_Coefficients; // q14, NUM_PHASES rows of NUM_TAPS taps
+		SharedData<int16_t> 	m_History; // m_HistorySize frames per channel, one channel after the other
+		unsigned int 		m_HistorySize;
+		unsigned int 		m_NumChannels;
+		unsigned int 		m_NumFrames; // frames in the history, the first being the first tap of the next output
+		uint32_t 		m_Step; // 0 if inactive
+		uint32_t 		m_Fraction; // the position between the first two frames of the history
+
+		void buildCoefficients (float cutoff);
+};
+
+#endif // POLYPHASERESAMPLER_HPP
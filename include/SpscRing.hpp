@@ -0,0 +1,90 @@
+#ifndef SPSCRING_HPP
+#define SPSCRING_HPP
+
+/**************************************************************************
+ * An SpscRing is a fixed-capacity FIFO between a single producer and a
+ * single consumer running in different contexts, such as an interrupt
+ * and the main loop on the target or two threads on host. Neither side
+ * ever waits on the other, since each index is only written by its own
+ * side.
+ *
+ * Note: The capacity must be a power of two, and all of it can be used.
+ * Only the producer may call push and only the consumer may call peek,
+ * pop, drop and clear.
+**************************************************************************/
+
+#include <atomic>
+#include <stdint.h>
+
+template <typename T, unsigned int CAPACITY>
+class SpscRing
+{
+	static_assert( CAPACITY > 0 && (CAPACITY & (CAPACITY - 1)) == 0, "the capacity must be a power of two" );
+
+	public:
+		SpscRing() :
+			m_Entries(),
+			m_WriteIndex( 0 ),
+			m_ReadIndex( 0 )
+		{
+		}
+
+		~SpscRing() {}
+
+		// returns false if the ring is full
+		bool push (const T& entry)
+		{
+			const uint32_t writeIndex = m_WriteIndex.load( std::memory_order_relaxed );
+			if ( writeIndex - m_ReadIndex.load(std::memory_order_acquire) == CAPACITY ) return false;
+
+			m_Entries[writeIndex & INDEX_MASK] = entry;
+			m_WriteIndex.store( writeIndex + 1, std::memory_order_release );
+
+			return true;
+		}
+
+		// the entry offset places after the oldest one, or nullptr if there aren't that many
+		const T* peek (unsigned int offset = 0) const
+		{
+			const uint32_t readIndex = m_ReadIndex.load( std::memory_order_relaxed );
+			if ( m_WriteIndex.load(std::memory_order_acquire) - readIndex <= offset ) return nullptr;
+
+			return &m_Entries[(readIndex + offset) & INDEX_MASK];
+		}
+
+		bool pop (T& entry)
+		{
+			const T* const oldestEntry = this->peek();
+			if ( ! oldestEntry ) return false;
+
+			entry = *oldestEntry;
+			m_ReadIndex.store( m_ReadIndex.load(std::memory_order_relaxed) + 1, std::memory_order_release );
+
+			return true;
+		}
+
+		void drop (unsigned int numEntries) // drops the oldest entries, at most as many as there are
+		{
+			const unsigned int numToDrop = ( numEntries < this->size() ) ? numEntries : this->size();
+			m_ReadIndex.store( m_ReadIndex.load(std::memory_order_relaxed) + numToDrop, std::memory_order_release );
+		}
+
+		void clear() { m_ReadIndex.store( m_WriteIndex.load(std::memory_order_acquire), std::memory_order_release ); }
+
+		unsigned int size() const
+		{
+			return m_WriteIndex.load( std::memory_order_acquire ) - m_ReadIndex.load( std::memory_order_acquire );
+		}
+		bool isEmpty() const { return this->size() == 0; }
+
+		static constexpr unsigned int capacity() { return CAPACITY; }
+
+	private:
+		static constexpr uint32_t INDEX_MASK = CAPACITY - 1;
+
+		T 			m_Entries[CAPACITY];
+		std::atomic<uint32_t> 	m_WriteIndex; // both indices run freely and wrap, only the bits under the mask pick the entry
+		std::atomic<uint32_t> 	m_ReadIndex;
+};
+
+#endif // SPSCRING_HPP
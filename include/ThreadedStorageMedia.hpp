@@ -0,0 +1,76 @@
+#ifndef THREADEDSTORAGEMEDIA_HPP
+#define THREADEDSTORAGEMEDIA_HPP
+
+/*******************************************************************
+ * A ThreadedStorageMedia is a host only IAsyncStorageMedia that
+ * services reads from a disk image on a pool of worker threads,
+ * so that pipelining storage reads with decoding can be exercised
+ * and benchmarked off target. Each worker opens its own stream
+ * on the image, so reads never share a file position, and reads
+ * land directly in the request's destination without a copy.
+ * CPPFile isn't used for the workers since it can only return a
+ * newly allocated SharedData for each read, not fill a buffer.
+ *
+ * Note: Reads only see data that has been flushed to the image
+ * file, which is fine for audio files since those are never
+ * written while streaming.
+*******************************************************************/
+
+#ifndef TARGET_BUILD
+
+#include "IAsyncStorageMedia.hpp"
+
+#include <condition_variable>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class ThreadedStorageMedia : public IAsyncStorageMedia
+{
+	public:
+		ThreadedStorageMedia (const std::string& imageFilename, unsigned int numWorkers = 2);
+		~ThreadedStorageMedia() override;
+
+		unsigned int submitRead (uint8_t* destination, unsigned int sizeInBytes, unsigned int byteAddress) override;
+		bool pollRead (unsigned int requestId) override;
+		void waitForRead (unsigned int requestId) override;
+
+	private:
+		enum class RequestState : unsigned int
+		{
+			FREE = 0,
+			QUEUED = 1,
+			COMPLETE = 2
+		};
+
+		struct Request
+		{
+			uint8_t* 		m_Destination = nullptr;
+			unsigned int 		m_SizeInBytes = 0;
+			unsigned int 		m_ByteAddress = 0;
+			RequestState 		m_State = RequestState::FREE;
+		};
+
+		Request 				m_Requests[ASYNC_STORAGE_MAX_REQUESTS];
+
+		unsigned int 				m_QueuedRequests[ASYNC_STORAGE_MAX_REQUESTS]; // fifo of request ids waiting for a worker
+		unsigned int 				m_QueueReadIndex;
+		unsigned int 				m_NumQueued;
+
+		std::mutex 				m_Mutex;
+		std::condition_variable 		m_RequestQueued;
+		std::condition_variable 		m_RequestCompleted;
+		bool 					m_ShouldStop;
+
+		std::vector<std::unique_ptr<std::ifstream>> 	m_Files;
+		std::vector<std::thread> 			m_Workers;
+
+		void workerLoop (std::ifstream* file);
+};
+
+#endif // TARGET_BUILD
+
+#endif // THREADEDSTORAGEMEDIA_HPP
@@ -0,0 +1,44 @@
+#ifndef WIRERATEMIDIOUTPUTQUEUE_HPP
+#define WIRERATEMIDIOUTPUTQUEUE_HPP
+
+/*************************************************************************
+ * A WireRateMidiOutputQueue is a host only MidiOutputQueue that stands
+ * in for the target's usart, sending its bytes no faster than the midi
+ * wire would at 31250 baud. It is ticked once per audio sample, and a
+ * byte comes out of it once the wire has had time to finish sending it,
+ * so the queue fills up on host just as it would on the target.
+ *
+ * Note: Each byte takes 10 bits on the wire (a start and a stop bit
+ * around its 8 data bits). The time left on the wire is kept in 1/256ths
+ * of a sample so that the average rate is exact at any sample rate.
+*************************************************************************/
+
+#ifndef TARGET_BUILD
+
+#include "MidiOutputQueue.hpp"
+#include "MnemonicConstants.hpp"
+
+constexpr unsigned int MIDI_WIRE_BAUD_RATE = 31250;
+constexpr unsigned int MIDI_WIRE_BITS_PER_BYTE = 10;
+
+class WireRateMidiOutputQueue : public MidiOutputQueue
+{
+	public:
+		WireRateMidiOutputQueue (unsigned int sampleRate = MNEMONIC_SAMPLE_RATE);
+		~WireRateMidiOutputQueue() override;
+
+		void setSampleRate (unsigned int sampleRate);
+
+		// lets a sample's worth of time pass on the wire, returns true with the byte that just finished sending if there is one
+		bool tick (uint8_t& byteSent);
+
+	private:
+		int32_t 	m_ByteTime; // in 1/256ths of a sample
+		int32_t 	m_TimeLeftOnWire; // for the byte on the wire, in 1/256ths of a sample
+		bool 		m_ByteIsOnWire;
+		uint8_t 	m_ByteOnWire;
+};
+
+#endif // TARGET_BUILD
+
+#endif // WIRERATEMIDIOUTPUTQUEUE_HPP
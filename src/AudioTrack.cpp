@@ -1,27 +1,56 @@
 #include "AudioTrack.hpp"
 
-#include "B12Compression.hpp"
-#include "Fat16FileManager.hpp"
+#include "MnemonicProfiler.hpp"
+
 #include <cstring>
+#include <limits>
 
 constexpr unsigned int COMPRESSED_BUFFER_SIZE = static_cast<unsigned int>( ABUFFER_SIZE * 2.0f * 0.75f );
+constexpr unsigned int COMPRESSED_CHUNK_SIZE = ( B12_DECODE_MIX_CHUNK_SIZE * 3 ) / 2; // in bytes, for a single channel
+static_assert( ABUFFER_SIZE % B12_DECODE_MIX_CHUNK_SIZE == 0, "audio blocks must be a whole number of decode and mix chunks" );
 
-AudioTrack::AudioTrack (unsigned int cellX, unsigned int cellY, Fat16FileManager* fileManager, const Fat16Entry& entry,
-			unsigned int b12BufferSize, IAllocator& allocator, uint16_t* decompressedBuffer) :
+static unsigned int BytesPerOutputBlock (unsigned int blockSizeInBytes, unsigned int sampleRate, unsigned int outputSampleRate)
+{
+	return static_cast<unsigned int>( ((static_cast<uint64_t>(blockSizeInBytes) * sampleRate) + outputSampleRate - 1) / outputSampleRate );
+}
+
+AudioTrack::AudioTrack (unsigned int cellX, unsigned int cellY, const Fat16SectorStream& stream, IAsyncStorageMedia& storageMedia,
+			const Fat16Entry& entry, unsigned int numChannels, unsigned int b12BufferSize, IAllocator& allocator,
+			unsigned int sampleRate, unsigned int outputSampleRate) :
 	m_CellX( cellX ),
 	m_CellY( cellY ),
-	m_FileManager( fileManager ),
+	m_Stream( stream ),
+	m_StorageMedia( &storageMedia ),
+	m_PendingReadId( ASYNC_STORAGE_INVALID_REQUEST ),
+	m_PendingReadNumSectors( 0 ),
+	m_PendingReadNumPolls( 0 ),
+	m_LastReadLatencyInBlocks( 0 ),
 	m_FatEntry( entry ),
-	m_FileLengthInAudioBlocks( (entry.getFileSizeInBytes() * (1.0f / 0.75f) * 0.5f) / ABUFFER_SIZE ),
+	m_NumChannels( numChannels ),
+	m_BlockSizeInBytes( COMPRESSED_BUFFER_SIZE * numChannels ),
+	m_BytesPerOutputBlock( m_BlockSizeInBytes ),
+	m_FileLengthInAudioBlocks( m_Stream.getDataSizeInBytes() / m_BlockSizeInBytes ),
 	m_LoopLengthInAudioBlocks( m_FileLengthInAudioBlocks ),
 	m_B12BufferSize( b12BufferSize ),
-	m_B12CircularBufferSize( m_B12BufferSize * 3 ),
+	m_Allocator( &allocator ),
+	m_B12CircularBufferSize( this->getRingUnitSizeInBytes() ),
 	m_B12CircularBuffer( SharedData<uint8_t>::MakeSharedData(m_B12CircularBufferSize, &allocator) ),
 	m_B12WritePos( 0 ),
 	m_B12ReadPos( 0 ),
-	m_DecompressedBuffer( decompressedBuffer ),
-	m_AmplitudeL( 1.0f ),
-	m_AmplitudeR( 1.0f ),
+	m_GainL( B12_DECODE_MIX_UNITY_GAIN ),
+	m_GainR( B12_DECODE_MIX_UNITY_GAIN ),
+	m_DecodeMix( B12SelectDecodeMix(m_GainL, m_GainR, numChannels == 2) ),
+	m_Resampler(),
+	m_DecodeResamplerInput( B12SelectDecodeMix(B12_DECODE_MIX_UNITY_GAIN, (numChannels == 2) ? B12_DECODE_MIX_UNITY_GAIN : 0,
+							numChannels == 2) ),
+	m_IsResident( false ),
+	m_HasStartedDecoding( false ),
+	m_NumUnderruns( 0 ),
+	m_MinBlocksBuffered( std::numeric_limits<unsigned int>::max() ),
+	m_LoopHead(),
+	m_LoopHeadSizeInBytes( 0 ),
+	m_LoopHeadStream( stream ),
+	m_IsPlaying( false ),
 	m_IsLoopable( false ),
 	m_LoopWaitForZero( false ),
 	m_JustFinished( false )
@@ -30,6 +59,21 @@ AudioTrack::AudioTrack (unsigned int cellX, unsigned int cellY, Fat16FileManager
 	{
 		m_B12CircularBuffer[byte] = 0;
 	}
+
+	// every play and loop restart walks the same chain, so walk it once now, a broken chain just keeps reading the fat
+	m_Stream.buildExtentMap( &allocator );
+	m_LoopHeadStream = m_Stream;
+
+	// a rate the resampler can't handle plays at the output rate, as it would have before files recorded their rate
+	if ( m_Resampler.configure(sampleRate, outputSampleRate, numChannels, ABUFFER_SIZE, B12_DECODE_MIX_CHUNK_SIZE, &allocator) )
+	{
+		m_BytesPerOutputBlock = BytesPerOutputBlock( m_BlockSizeInBytes, sampleRate, outputSampleRate );
+		m_FileLengthInAudioBlocks = m_Stream.getDataSizeInBytes() / m_BytesPerOutputBlock;
+		m_LoopLengthInAudioBlocks = m_FileLengthInAudioBlocks;
+	}
+
+	// the ring has to hold the most a block can consume plus a sector in flight, which a single unit may not
+	this->setRingDepth( this->getRingDepth() );
 }
 
 AudioTrack::~AudioTrack()
@@ -47,16 +91,51 @@ bool AudioTrack::operator== (const AudioTrack& other) const
 
 void AudioTrack::play()
 {
+	if ( ! m_IsResident && m_LoopHeadSizeInBytes > 0 )
+	{
+		this->restartFromLoopHead();
+
+		return;
+	}
+
 	this->reset();
 
-	m_FileManager->readEntry( m_FatEntry );
+	if ( m_IsResident )
+	{
+		// the whole file is already buffered, so it is only a matter of decoding it from the start
+		m_B12WritePos = ( m_Stream.getDataSizeInBytes() / m_BlockSizeInBytes ) * m_BlockSizeInBytes;
+		m_IsPlaying = m_FileLengthInAudioBlocks > 0;
+
+		return;
+	}
+
+	m_Stream.rewind();
+	m_IsPlaying = ! m_Stream.isFinished();
 }
 
 void AudioTrack::reset()
 {
 	m_JustFinished = false;
+	m_HasStartedDecoding = false;
+	m_Resampler.reset();
+
+	if ( m_IsResident )
+	{
+		m_IsPlaying = false;
+		m_B12WritePos = 0;
+		m_B12ReadPos = 0;
+
+		return;
+	}
+
+	// the read in flight is writing into the circular buffer, so it has to land before the buffer can be reused
+	if ( m_PendingReadId != ASYNC_STORAGE_INVALID_REQUEST )
+	{
+		m_StorageMedia->waitForRead( m_PendingReadId );
+		m_PendingReadId = ASYNC_STORAGE_INVALID_REQUEST;
+	}
 
-	m_FatEntry.getFileTransferInProgressFlagRef() = false;
+	m_IsPlaying = false;
 
 	m_B12WritePos = 0;
 	m_B12ReadPos = 0;
@@ -69,87 +148,359 @@ void AudioTrack::reset()
 
 void AudioTrack::setAmplitudes (const float amplitudeL, const float amplitudeR)
 {
-	m_AmplitudeL = amplitudeL;
-	m_AmplitudeR = amplitudeR;
+	m_GainL = B12GainFromAmplitude( amplitudeL );
+	m_GainR = B12GainFromAmplitude( amplitudeR );
+	m_DecodeMix = B12SelectDecodeMix( m_GainL, m_GainR, m_NumChannels == 2 );
 }
 
-bool AudioTrack::shouldFillNextBuffer()
+bool AudioTrack::shouldFillNextBuffer() const
 {
-	if ( m_B12ReadPos <= m_B12WritePos && m_B12ReadPos + COMPRESSED_BUFFER_SIZE >= m_B12WritePos )
+	return this->getNumSectorsToFill() > 0;
+}
+
+bool AudioTrack::needsNextSector() const
+{
+	return ! m_IsResident && this->isPlaying() && m_PendingReadId == ASYNC_STORAGE_INVALID_REQUEST && this->shouldFillNextBuffer();
+}
+
+unsigned int AudioTrack::submitNextSectors (unsigned int maxSectors)
+{
+	const unsigned int numSectorsToFill = this->getNumSectorsToFill();
+	maxSectors = ( maxSectors < numSectorsToFill ) ? maxSectors : numSectorsToFill;
+	if ( ! this->needsNextSector() || maxSectors == 0 ) return 0;
+
+	unsigned int byteAddress = 0;
+	const unsigned int numSectors = m_Stream.nextSectorRun( maxSectors, byteAddress );
+	const unsigned int requestId = m_StorageMedia->submitRead( &m_B12CircularBuffer[m_B12WritePos], numSectors * m_B12BufferSize,
+									byteAddress );
+	if ( requestId == ASYNC_STORAGE_INVALID_REQUEST ) return 0;
+
+	m_Stream.advance( numSectors );
+	m_PendingReadId = requestId;
+	m_PendingReadNumSectors = numSectors;
+	m_PendingReadNumPolls = 0;
+
+	return numSectors;
+}
+
+bool AudioTrack::pollPendingRead()
+{
+	if ( m_PendingReadId == ASYNC_STORAGE_INVALID_REQUEST ) return false;
+
+	if ( m_StorageMedia->pollRead(m_PendingReadId) )
 	{
+		this->completePendingRead();
+
 		return true;
 	}
-	else if ( m_B12ReadPos > m_B12WritePos && m_B12WritePos + m_B12BufferSize < m_B12ReadPos )
+
+	m_PendingReadNumPolls++;
+
+	return false;
+}
+
+void AudioTrack::completePendingRead()
+{
+	m_PendingReadId = ASYNC_STORAGE_INVALID_REQUEST;
+	m_LastReadLatencyInBlocks = m_PendingReadNumPolls;
+	m_B12WritePos = ( m_B12WritePos + (m_B12BufferSize * m_PendingReadNumSectors) ) % m_B12CircularBufferSize;
+
+	if ( m_Stream.isFinished() )
 	{
-		return true;
+		m_IsPlaying = false;
+		m_JustFinished = true;
 	}
+}
 
-	return false;
+unsigned int AudioTrack::getNumSectorsToFill() const
+{
+	// the buffer is never filled completely, since a full buffer would look the same as an empty one
+	const unsigned int bytesBuffered = ( m_B12WritePos + m_B12CircularBufferSize - m_B12ReadPos ) % m_B12CircularBufferSize;
+	const unsigned int sectorsFree = ( m_B12CircularBufferSize - bytesBuffered - 1 ) / m_B12BufferSize;
+	const unsigned int sectorsUntilWrap = ( m_B12CircularBufferSize - m_B12WritePos ) / m_B12BufferSize;
+
+	return ( sectorsFree < sectorsUntilWrap ) ? sectorsFree : sectorsUntilWrap;
 }
 
-void AudioTrack::fillNextBuffer (const uint8_t* const compressedBuf)
+unsigned int AudioTrack::getRingUnitSizeInAudioBlocks() const
 {
-	uint8_t* nextBuffer = &m_B12CircularBuffer[m_B12WritePos];
+	// a file at a higher rate than the output's consumes more than a unit per block, which still counts as one
+	const unsigned int ringUnitSizeInBlocks = this->getRingUnitSizeInBytes() / m_BytesPerOutputBlock;
 
-	std::memcpy( nextBuffer, compressedBuf, m_B12BufferSize );
+	return ( ringUnitSizeInBlocks > 0 ) ? ringUnitSizeInBlocks : 1;
+}
 
-	m_B12WritePos = ( m_B12WritePos + m_B12BufferSize ) % m_B12CircularBufferSize;
+unsigned int AudioTrack::getRingUnitsToCover (unsigned int numAudioBlocks) const
+{
+	// in bytes rather than whole blocks per unit, since a unit may hold a fraction of a block or a block and a fraction
+	const uint64_t bytesToCover = static_cast<uint64_t>( numAudioBlocks ) * m_BytesPerOutputBlock;
+	const unsigned int ringUnitSizeInBytes = this->getRingUnitSizeInBytes();
+
+	return static_cast<unsigned int>( (bytesToCover + ringUnitSizeInBytes - 1) / ringUnitSizeInBytes ) + 1;
 }
 
-void AudioTrack::call (int16_t* writeBufferL, int16_t* writeBufferR)
+void AudioTrack::setRingDepth (unsigned int numRingUnits)
 {
-	if ( m_FatEntry.getFileTransferInProgressFlagRef() )
+	if ( m_IsResident ) return;
+
+	// the read in flight targets the current buffer, so land it first
+	if ( m_PendingReadId != ASYNC_STORAGE_INVALID_REQUEST )
 	{
-		while ( this->shouldFillNextBuffer() )
-		{
-			SharedData<uint8_t> data = m_FileManager->getSelectedFileNextSector( m_FatEntry );
-			if ( m_FatEntry.getFileTransferInProgressFlagRef() || data.getPtr() != nullptr )
-			{
-				this->fillNextBuffer( &data[0] );
-			}
-			else
-			{
-				break;
-			}
-		}
+		m_StorageMedia->waitForRead( m_PendingReadId );
+		this->completePendingRead();
+	}
+
+	const unsigned int bytesBuffered = ( m_B12WritePos + m_B12CircularBufferSize - m_B12ReadPos ) % m_B12CircularBufferSize;
+	const unsigned int bytesKept = ( bytesBuffered > m_LoopHeadSizeInBytes ) ? bytesBuffered : m_LoopHeadSizeInBytes;
+	const unsigned int minNumRingUnits = ( bytesKept / this->getRingUnitSizeInBytes() ) + 1;
+	numRingUnits = ( numRingUnits > minNumRingUnits ) ? numRingUnits : minNumRingUnits;
+	// the buffer is never filled completely, so a block's worth plus the next sector must fit in less than the whole buffer
+	const unsigned int minNumRingUnitsToDecode = ( this->getMaxBytesToDecode() + m_B12BufferSize ) / this->getRingUnitSizeInBytes() + 1;
+	numRingUnits = ( numRingUnits > minNumRingUnitsToDecode ) ? numRingUnits : minNumRingUnitsToDecode;
+
+	const unsigned int newBufferSize = this->getRingUnitSizeInBytes() * numRingUnits;
+	if ( newBufferSize == m_B12CircularBufferSize ) return;
 
-		if ( ! m_FatEntry.getFileTransferInProgressFlagRef() ) m_JustFinished = true;
+	// move whatever is buffered into the new buffer, keeping the read position's offset within a ring unit so that reads stay
+	// aligned to compressed audio blocks and writes stay aligned to sectors
+	SharedData<uint8_t> newBuffer = SharedData<uint8_t>::MakeSharedData( newBufferSize, m_Allocator );
+	const unsigned int newReadPos = m_B12ReadPos % this->getRingUnitSizeInBytes();
+	for ( unsigned int byte = 0; byte < newBufferSize; byte++ )
+	{
+		newBuffer[byte] = 0;
+	}
+	for ( unsigned int byte = 0; byte < bytesBuffered; byte++ )
+	{
+		newBuffer[(newReadPos + byte) % newBufferSize] = m_B12CircularBuffer[(m_B12ReadPos + byte) % m_B12CircularBufferSize];
 	}
 
+	m_B12CircularBuffer = newBuffer;
+	m_B12CircularBufferSize = newBufferSize;
+	m_B12ReadPos = newReadPos;
+	m_B12WritePos = ( newReadPos + bytesBuffered ) % newBufferSize;
+
+	// the old low-water mark says nothing about the new depth
+	m_MinBlocksBuffered = std::numeric_limits<unsigned int>::max();
+}
+
+bool AudioTrack::makeResident()
+{
+	if ( m_IsResident ) return true;
+
+	this->reset();
+
+	const unsigned int residentSizeInBytes = this->getResidentSizeInBytes();
+	SharedData<uint8_t> residentBuffer = SharedData<uint8_t>::MakeSharedData( residentSizeInBytes, m_Allocator );
+
+	const unsigned int bytesRead = this->readFromStart( &residentBuffer[0], residentSizeInBytes );
+	m_Stream.rewind();
+	if ( bytesRead < residentSizeInBytes ) return false;
+
+	m_B12CircularBuffer = residentBuffer;
+	m_B12CircularBufferSize = residentSizeInBytes;
+	m_IsResident = true;
+
+	return true;
+}
+
+bool AudioTrack::loadLoopHead (unsigned int numSectors)
+{
+	if ( m_IsResident || numSectors == 0 ) return false;
+
+	this->reset();
+
+	const unsigned int maxBytes = numSectors * m_B12BufferSize;
+	SharedData<uint8_t> loopHead = SharedData<uint8_t>::MakeSharedData( maxBytes, m_Allocator );
+
+	// a file shorter than the loop head is held whole
+	const unsigned int bytesRead = this->readFromStart( &loopHead[0], maxBytes );
+	const Fat16SectorStream streamAfterLoopHead = m_Stream;
+	m_Stream.rewind();
+	if ( bytesRead < maxBytes && bytesRead < this->getResidentSizeInBytes() ) return false;
+
+	m_LoopHead = loopHead;
+	m_LoopHeadSizeInBytes = bytesRead;
+	m_LoopHeadStream = streamAfterLoopHead;
+
+	// the circular buffer has to hold the whole loop head with room to spare
+	this->setRingDepth( this->getRingDepth() );
+
+	return true;
+}
+
+unsigned int AudioTrack::readFromStart (uint8_t* dest, unsigned int maxBytes)
+{
+	// this happens on load rather than in the audio callback, so waiting on each read is fine
+	m_Stream.rewind();
+	unsigned int bytesRead = 0;
+	while ( ! m_Stream.isFinished() && bytesRead + m_B12BufferSize <= maxBytes )
+	{
+		unsigned int byteAddress = 0;
+		const unsigned int numSectors = m_Stream.nextSectorRun( (maxBytes - bytesRead) / m_B12BufferSize, byteAddress );
+		const unsigned int requestId = m_StorageMedia->submitRead( &dest[bytesRead], numSectors * m_B12BufferSize, byteAddress );
+		if ( requestId == ASYNC_STORAGE_INVALID_REQUEST ) break;
+
+		m_StorageMedia->waitForRead( requestId );
+		m_Stream.advance( numSectors );
+		bytesRead += numSectors * m_B12BufferSize;
+	}
+
+	return bytesRead;
+}
+
+void AudioTrack::restartFromLoopHead()
+{
+	// only a track that fell behind still has a read in flight at its loop boundary, its data is stale now anyway
+	if ( m_PendingReadId != ASYNC_STORAGE_INVALID_REQUEST )
+	{
+		m_StorageMedia->waitForRead( m_PendingReadId );
+		m_PendingReadId = ASYNC_STORAGE_INVALID_REQUEST;
+	}
+
+	// setRingDepth always leaves room for the loop head, and nothing past the write position is decoded so the rest of the
+	// buffer doesn't need clearing
+	std::memcpy( &m_B12CircularBuffer[0], &m_LoopHead[0], m_LoopHeadSizeInBytes );
+	m_B12ReadPos = 0;
+	m_B12WritePos = m_LoopHeadSizeInBytes;
+	m_HasStartedDecoding = false;
+	m_Resampler.reset();
+
+	// a file that fits in its loop head has nothing left to stream, which counts as finishing straight away
+	m_Stream = m_LoopHeadStream;
+	m_IsPlaying = ! m_Stream.isFinished();
+	m_JustFinished = ! m_IsPlaying;
+}
+
+unsigned int AudioTrack::getResidentSizeInBytes() const
+{
+	// whole sectors are read, so the last one may run past the end of the file
+	return ( (m_Stream.getDataSizeInBytes() + m_B12BufferSize - 1) / m_B12BufferSize ) * m_B12BufferSize;
+}
+
+unsigned int AudioTrack::getBlocksUntilUnderrun() const
+{
+	if ( m_IsResident ) return ( m_B12WritePos - m_B12ReadPos ) / m_BytesPerOutputBlock;
+
+	const unsigned int bytesBuffered = ( m_B12WritePos + m_B12CircularBufferSize - m_B12ReadPos ) % m_B12CircularBufferSize;
+
+	return bytesBuffered / m_BytesPerOutputBlock;
+}
+
+unsigned int AudioTrack::getBytesToDecode() const
+{
+	if ( ! m_Resampler.isActive() ) return m_BlockSizeInBytes;
+
+	// whole chunks are decoded, so up to a chunk more than the resampler asked for stays in its history for the next block
+	const unsigned int numChunks = ( m_Resampler.getSourceFramesNeeded(ABUFFER_SIZE) + B12_DECODE_MIX_CHUNK_SIZE - 1 )
+					/ B12_DECODE_MIX_CHUNK_SIZE;
+
+	return numChunks * COMPRESSED_CHUNK_SIZE * m_NumChannels;
+}
+
+unsigned int AudioTrack::getMaxBytesToDecode() const
+{
+	if ( ! m_Resampler.isActive() ) return m_BlockSizeInBytes;
+
+	const unsigned int maxSourceFrames = static_cast<unsigned int>( (static_cast<uint64_t>(m_Resampler.getStep()) * ABUFFER_SIZE)
+						>> POLYPHASE_RESAMPLER_FRACTION_BITS ) + POLYPHASE_RESAMPLER_NUM_TAPS + 1;
+	const unsigned int numChunks = ( maxSourceFrames + B12_DECODE_MIX_CHUNK_SIZE - 1 ) / B12_DECODE_MIX_CHUNK_SIZE;
+
+	return numChunks * COMPRESSED_CHUNK_SIZE * m_NumChannels;
+}
+
+void AudioTrack::advanceReadPos (unsigned int numBytes)
+{
+	if ( m_IsResident )
+	{
+		m_B12ReadPos += numBytes;
+
+		return;
+	}
+
+	m_B12ReadPos = ( m_B12ReadPos + numBytes ) % m_B12CircularBufferSize;
+}
+
+void AudioTrack::call (int32_t* mixBusL, int32_t* mixBusR)
+{
+	MNEMONIC_PROFILE_SCOPE( ProfileScope::AUDIO_TRACK_CALL );
+
+	const bool isStreaming = m_IsPlaying && ! m_IsResident;
+
 	if ( this->shouldDecompress() )
 	{
-		this->decompressToBuffer( writeBufferL, writeBufferR );
+		if ( isStreaming )
+		{
+			const unsigned int blocksBuffered = this->getBlocksUntilUnderrun();
+			if ( blocksBuffered < m_MinBlocksBuffered ) m_MinBlocksBuffered = blocksBuffered;
+		}
+
+		this->decompressToBuffer( mixBusL, mixBusR );
+		m_HasStartedDecoding = true;
+	}
+	else if ( isStreaming && m_HasStartedDecoding )
+	{
+		m_NumUnderruns++;
+		m_MinBlocksBuffered = 0;
 	}
 }
 
 bool AudioTrack::shouldDecompress()
 {
-	if ( m_B12ReadPos < m_B12WritePos && m_B12ReadPos + COMPRESSED_BUFFER_SIZE <= m_B12WritePos )
+	const unsigned int bytesToDecode = this->getBytesToDecode();
+
+	if ( m_IsResident ) return m_B12ReadPos + bytesToDecode <= m_B12WritePos;
+
+	const unsigned int bytesBuffered = ( m_B12WritePos + m_B12CircularBufferSize - m_B12ReadPos ) % m_B12CircularBufferSize;
+
+	return bytesBuffered >= bytesToDecode;
+}
+
+void AudioTrack::decompressToBuffer (int32_t* mixBusL, int32_t* mixBusR)
+{
+	if ( m_Resampler.isActive() )
 	{
-		return true;
+		this->resampleToBuffer( mixBusL, mixBusR );
 	}
-	else if ( m_B12ReadPos > m_B12WritePos && m_B12CircularBufferSize - m_B12ReadPos + m_B12WritePos >= COMPRESSED_BUFFER_SIZE )
+	else
 	{
-		return true;
+		{
+			MNEMONIC_PROFILE_SCOPE( ProfileScope::B12_DECODE_MIX );
+			m_DecodeMix( &m_B12CircularBuffer[m_B12ReadPos], ABUFFER_SIZE, mixBusL, mixBusR, m_GainL, m_GainR );
+		}
+
+		this->advanceReadPos( m_BlockSizeInBytes );
 	}
 
-	return false;
+	// there is no stream to finish, so a resident track finishes with its last block instead
+	if ( m_IsResident && m_IsPlaying && ! this->shouldDecompress() )
+	{
+		m_IsPlaying = false;
+		m_JustFinished = true;
+	}
 }
 
-void AudioTrack::decompressToBuffer (int16_t* writeBufferL, int16_t* writeBufferR)
+void AudioTrack::resampleToBuffer (int32_t* mixBusL, int32_t* mixBusR)
 {
-	uint8_t* compressedBuffer = &m_B12CircularBuffer[m_B12ReadPos];
-
-	B12Decompress( compressedBuffer, COMPRESSED_BUFFER_SIZE, m_DecompressedBuffer, ABUFFER_SIZE );
+	// chunks tile the ring units exactly, so a chunk never wraps around the circular buffer
+	const unsigned int bytesToDecode = this->getBytesToDecode();
+	const unsigned int chunkSizeInBytes = COMPRESSED_CHUNK_SIZE * m_NumChannels;
+	const int16_t chunkGainR = ( m_NumChannels == 2 ) ? B12_DECODE_MIX_UNITY_GAIN : 0; // a single channel only needs one bus
 
-	for ( unsigned int sample = 0; sample < ABUFFER_SIZE; sample++ )
 	{
-		int16_t sampleVal = ( static_cast<int16_t>(m_DecompressedBuffer[sample]) - (4096 / 2) ) / 2;
-		writeBufferL[sample] += sampleVal * m_AmplitudeL;
-		writeBufferR[sample] += sampleVal * m_AmplitudeR;
+		MNEMONIC_PROFILE_SCOPE( ProfileScope::B12_DECODE_MIX );
+		for ( unsigned int byte = 0; byte < bytesToDecode; byte += chunkSizeInBytes )
+		{
+			int32_t chunkL[B12_DECODE_MIX_CHUNK_SIZE] = { 0 };
+			int32_t chunkR[B12_DECODE_MIX_CHUNK_SIZE] = { 0 };
+			m_DecodeResamplerInput( &m_B12CircularBuffer[m_B12ReadPos], B12_DECODE_MIX_CHUNK_SIZE, chunkL, chunkR,
+						B12_DECODE_MIX_UNITY_GAIN, chunkGainR );
+			m_Resampler.pushSourceFrames( chunkL, chunkR, B12_DECODE_MIX_CHUNK_SIZE );
+			this->advanceReadPos( chunkSizeInBytes );
+		}
 	}
 
-	m_B12ReadPos = ( m_B12ReadPos + COMPRESSED_BUFFER_SIZE ) % m_B12CircularBufferSize;
+	MNEMONIC_PROFILE_SCOPE( ProfileScope::RESAMPLE );
+	m_Resampler.process( ABUFFER_SIZE, mixBusL, mixBusR, m_GainL, m_GainR );
 }
 
 void AudioTrack::setLoopable (const bool isLoopable, const bool loopWaitForZero)
@@ -0,0 +1,50 @@
+#include "B12Container.hpp"
+
+#include "B12DecodeMix.hpp"
+#include <cstring>
+
+static const char B12_CONTAINER_MAGIC[4] = { 'B', '1', '2', 'S' };
+
+bool B12ReadContainerHeader (const uint8_t* data, unsigned int sizeInBytes, B12ContainerHeader& header)
+{
+	header = B12ContainerHeader();
+
+	if ( sizeInBytes < B12_CONTAINER_HEADER_SIZE || std::memcmp(data, B12_CONTAINER_MAGIC, sizeof(B12_CONTAINER_MAGIC)) != 0 )
+	{
+		// a plain single channel b12 file
+		return true;
+	}
+
+	const unsigned int version = data[4];
+	const unsigned int numChannels = data[5];
+	const unsigned int framesPerChunk = data[6] | ( data[7] << 8 );
+	const unsigned int minNumChannels = ( version == 1 ) ? 2 : 1;
+	if ( version < 1 || version > B12_CONTAINER_VERSION || numChannels < minNumChannels || numChannels > 2
+		|| framesPerChunk != B12_DECODE_MIX_CHUNK_SIZE )
+	{
+		return false;
+	}
+
+	header.m_NumChannels = numChannels;
+	header.m_HeaderSizeInBytes = B12_CONTAINER_HEADER_SIZE;
+	if ( version >= 2 )
+	{
+		header.m_SampleRate = data[8] | ( data[9] << 8 ) | ( data[10] << 16 ) | ( static_cast<unsigned int>(data[11]) << 24 );
+	}
+
+	return true;
+}
+
+void B12WriteContainerHeader (uint8_t* data, unsigned int numChannels, unsigned int sampleRate)
+{
+	std::memset( data, 0, B12_CONTAINER_HEADER_SIZE );
+	std::memcpy( data, B12_CONTAINER_MAGIC, sizeof(B12_CONTAINER_MAGIC) );
+	data[4] = B12_CONTAINER_VERSION;
+	data[5] = numChannels;
+	data[6] = ( B12_DECODE_MIX_CHUNK_SIZE >> 0 ) & 0xFF;
+	data[7] = ( B12_DECODE_MIX_CHUNK_SIZE >> 8 ) & 0xFF;
+	data[8] = ( sampleRate >> 0 ) & 0xFF;
+	data[9] = ( sampleRate >> 8 ) & 0xFF;
+	data[10] = ( sampleRate >> 16 ) & 0xFF;
+	data[11] = ( sampleRate >> 24 ) & 0xFF;
+}
@@ -0,0 +1,345 @@
+#include "B12DecodeMix.hpp"
+
+#include "B12Compression.hpp"
+#include <cstring>
+
+#if defined( __ARM_FEATURE_SIMD32 )
+#include <arm_acle.h>
+#elif defined( __AVX2__ )
+#include <immintrin.h>
+#elif defined( __SSE2__ )
+#include <emmintrin.h>
+#endif
+
+constexpr unsigned int B12_DECODE_MIX_CHUNK_SIZE_IN_BYTES = ( B12_DECODE_MIX_CHUNK_SIZE * 3 ) / 2;
+constexpr int16_t B12_SAMPLE_CENTRE = 4096 / 2;
+
+int16_t B12GainFromAmplitude (const float amplitude)
+{
+	const float gain = amplitude * B12_DECODE_MIX_UNITY_GAIN;
+
+	if ( gain >= 32767.0f ) return 32767;
+	if ( gain <= -32768.0f ) return -32768;
+
+	return static_cast<int16_t>( gain );
+}
+
+// the gain of one bus, a zero gain bus is skipped entirely and a unity gain bus skips the multiply
+enum class MixGain : unsigned int
+{
+	ZERO 		= 0,
+	UNITY 		= 1,
+	GENERIC 	= 2
+};
+
+constexpr unsigned int NUM_MIX_GAINS = 3;
+
+static inline MixGain mixGainFor (const int16_t gain)
+{
+	if ( gain == 0 ) return MixGain::ZERO;
+	if ( gain == B12_DECODE_MIX_UNITY_GAIN ) return MixGain::UNITY;
+
+	return MixGain::GENERIC;
+}
+
+static inline int32_t scaleSample (const uint16_t sample, const int16_t gain)
+{
+	// |sample| is at most 1024 after halving, so the product always fits comfortably in 32 bits
+	const int32_t sampleVal = ( static_cast<int32_t>(sample) - B12_SAMPLE_CENTRE ) >> 1;
+
+	return ( sampleVal * gain ) >> 14;
+}
+
+static inline void mixChunkScalar (const uint16_t* samples, unsigned int numSamples, int32_t* bus, int16_t gain)
+{
+	for ( unsigned int sample = 0; sample < numSamples; sample++ )
+	{
+		bus[sample] += scaleSample( samples[sample], gain );
+	}
+}
+
+// the b12 layout these kernels unpack must stay exactly the one B12Decompress reads, which the scalar reference still uses:
+// every 3 bytes hold two 12-bit samples, the first in the low byte and the low nibble of the middle byte, the second in the
+// high nibble of the middle byte and the high byte. read as a little endian word, each sample is simply the next 12 bits
+//
+// the branches on GAIN below are resolved at compile time, a unity gain of 1 << 14 gives exactly the unscaled sample
+
+#if defined( __ARM_FEATURE_SIMD32 )
+
+constexpr unsigned int B12_DECODE_MIX_SAMPLES_PER_STEP = 4; // in 6 bytes
+
+template <MixGain GAIN>
+static inline void mixSamplePair (const uint32_t samplePair, int32_t* bus, const int16_t gain)
+{
+	if ( GAIN == MixGain::ZERO ) return;
+
+	const uint32_t centre = ( B12_SAMPLE_CENTRE << 16 ) | B12_SAMPLE_CENTRE;
+
+	// recentre then halve both samples at once, the halving add floors just like the scalar shift
+	const int32_t sampleVals = __shadd16( __ssub16(samplePair, centre), 0 );
+	if ( GAIN == MixGain::UNITY )
+	{
+		bus[0] += static_cast<int16_t>( sampleVals & 0xFFFF );
+		bus[1] += sampleVals >> 16;
+	}
+	else
+	{
+		bus[0] += __smulbb( sampleVals, gain ) >> 14;
+		bus[1] += __smultb( sampleVals, gain ) >> 14;
+	}
+}
+
+template <MixGain GAIN_L, MixGain GAIN_R>
+static inline void decodeMixChunk (const uint8_t* compressed, int32_t* busL, int32_t* busR, int16_t gainL, int16_t gainR)
+{
+	for ( unsigned int sample = 0; sample < B12_DECODE_MIX_CHUNK_SIZE; sample += B12_DECODE_MIX_SAMPLES_PER_STEP )
+	{
+		// two overlapping words cover the 6 bytes without reading past them, then each pair of samples is moved into halfwords
+		uint32_t bytes0To3;
+		uint32_t bytes2To5;
+		std::memcpy( &bytes0To3, &compressed[0], sizeof(bytes0To3) );
+		std::memcpy( &bytes2To5, &compressed[2], sizeof(bytes2To5) );
+		const uint32_t samples01 = ( bytes0To3 & 0x00000FFF ) | ( (bytes0To3 << 4) & 0x0FFF0000 );
+		const uint32_t samples23 = ( (bytes2To5 >> 8) & 0x00000FFF ) | ( (bytes2To5 >> 4) & 0x0FFF0000 );
+
+		mixSamplePair<GAIN_L>( samples01, &busL[sample + 0], gainL );
+		mixSamplePair<GAIN_L>( samples23, &busL[sample + 2], gainL );
+		mixSamplePair<GAIN_R>( samples01, &busR[sample + 0], gainR );
+		mixSamplePair<GAIN_R>( samples23, &busR[sample + 2], gainR );
+
+		compressed += ( B12_DECODE_MIX_SAMPLES_PER_STEP * 3 ) / 2;
+	}
+}
+
+#elif defined( __AVX2__ )
+
+constexpr unsigned int B12_DECODE_MIX_SAMPLES_PER_STEP = 16; // in 24 bytes
+
+// 8 samples from 12 bytes, 6 bytes in each 64 bit lane with nothing read past the 12 bytes
+static inline __m128i loadSamples (const uint8_t* compressed)
+{
+	const __m128i bytes0To7 = _mm_loadl_epi64( reinterpret_cast<const __m128i*>(&compressed[0]) );
+	const __m128i bytes4To11 = _mm_loadl_epi64( reinterpret_cast<const __m128i*>(&compressed[4]) );
+
+	return _mm_unpacklo_epi64( bytes0To7, _mm_srli_epi64(bytes4To11, 16) );
+}
+
+template <MixGain GAIN>
+static inline void mixSamples (const __m256i samples, int32_t* bus, const __m256i gainVec)
+{
+	if ( GAIN == MixGain::ZERO ) return;
+
+	const __m256i centre = _mm256_set1_epi16( B12_SAMPLE_CENTRE );
+	const __m256i sampleVals = _mm256_srai_epi16( _mm256_sub_epi16(samples, centre), 1 );
+
+	// (sampleVal << 2) * gain >> 16 is exactly sampleVal * gain >> 14, and sampleVal << 2 still fits in 16 bits
+	const __m256i scaled = ( GAIN == MixGain::UNITY ) ? sampleVals : _mm256_mulhi_epi16( _mm256_slli_epi16(sampleVals, 2), gainVec );
+
+	__m256i* busVecLo = reinterpret_cast<__m256i*>( &bus[0] );
+	__m256i* busVecHi = reinterpret_cast<__m256i*>( &bus[8] );
+	const __m256i scaledLo = _mm256_cvtepi16_epi32( _mm256_castsi256_si128(scaled) );
+	const __m256i scaledHi = _mm256_cvtepi16_epi32( _mm256_extracti128_si256(scaled, 1) );
+	_mm256_storeu_si256( busVecLo, _mm256_add_epi32(_mm256_loadu_si256(busVecLo), scaledLo) );
+	_mm256_storeu_si256( busVecHi, _mm256_add_epi32(_mm256_loadu_si256(busVecHi), scaledHi) );
+}
+
+template <MixGain GAIN_L, MixGain GAIN_R>
+static inline void decodeMixChunk (const uint8_t* compressed, int32_t* busL, int32_t* busR, int16_t gainL, int16_t gainR)
+{
+	const __m256i gainVecL = _mm256_set1_epi16( gainL );
+	const __m256i gainVecR = _mm256_set1_epi16( gainR );
+	const __m256i mask0 = _mm256_set1_epi64x( 0x0000000000000FFF );
+	const __m256i mask1 = _mm256_set1_epi64x( 0x000000000FFF0000 );
+	const __m256i mask2 = _mm256_set1_epi64x( 0x00000FFF00000000 );
+	const __m256i mask3 = _mm256_set1_epi64x( 0x0FFF000000000000 );
+
+	for ( unsigned int sample = 0; sample < B12_DECODE_MIX_CHUNK_SIZE; sample += B12_DECODE_MIX_SAMPLES_PER_STEP )
+	{
+		const __m256i packed = _mm256_inserti128_si256( _mm256_castsi128_si256(loadSamples(&compressed[0])),
+								loadSamples(&compressed[12]), 1 );
+
+		// each lane holds 4 samples 12 bits apart, shifting each one up to its own 16 bit lane unpacks the lot
+		const __m256i samples = _mm256_or_si256( _mm256_or_si256(_mm256_and_si256(packed, mask0),
+										_mm256_and_si256(_mm256_slli_epi64(packed, 4), mask1)),
+							_mm256_or_si256(_mm256_and_si256(_mm256_slli_epi64(packed, 8), mask2),
+										_mm256_and_si256(_mm256_slli_epi64(packed, 12), mask3)) );
+
+		mixSamples<GAIN_L>( samples, &busL[sample], gainVecL );
+		mixSamples<GAIN_R>( samples, &busR[sample], gainVecR );
+
+		compressed += ( B12_DECODE_MIX_SAMPLES_PER_STEP * 3 ) / 2;
+	}
+}
+
+#elif defined( __SSE2__ )
+
+constexpr unsigned int B12_DECODE_MIX_SAMPLES_PER_STEP = 8; // in 12 bytes
+
+template <MixGain GAIN>
+static inline void mixSamples (const __m128i samples, int32_t* bus, const __m128i gainVec)
+{
+	if ( GAIN == MixGain::ZERO ) return;
+
+	const __m128i centre = _mm_set1_epi16( B12_SAMPLE_CENTRE );
+	const __m128i sampleVals = _mm_srai_epi16( _mm_sub_epi16(samples, centre), 1 );
+
+	// (sampleVal << 2) * gain >> 16 is exactly sampleVal * gain >> 14, and sampleVal << 2 still fits in 16 bits
+	const __m128i scaled = ( GAIN == MixGain::UNITY ) ? sampleVals : _mm_mulhi_epi16( _mm_slli_epi16(sampleVals, 2), gainVec );
+
+	// sign extend to 32 bits by unpacking each value into the top half then shifting it back down
+	__m128i* busVecLo = reinterpret_cast<__m128i*>( &bus[0] );
+	__m128i* busVecHi = reinterpret_cast<__m128i*>( &bus[4] );
+	const __m128i scaledLo = _mm_srai_epi32( _mm_unpacklo_epi16(scaled, scaled), 16 );
+	const __m128i scaledHi = _mm_srai_epi32( _mm_unpackhi_epi16(scaled, scaled), 16 );
+	_mm_storeu_si128( busVecLo, _mm_add_epi32(_mm_loadu_si128(busVecLo), scaledLo) );
+	_mm_storeu_si128( busVecHi, _mm_add_epi32(_mm_loadu_si128(busVecHi), scaledHi) );
+}
+
+template <MixGain GAIN_L, MixGain GAIN_R>
+static inline void decodeMixChunk (const uint8_t* compressed, int32_t* busL, int32_t* busR, int16_t gainL, int16_t gainR)
+{
+	const __m128i gainVecL = _mm_set1_epi16( gainL );
+	const __m128i gainVecR = _mm_set1_epi16( gainR );
+	const __m128i mask0 = _mm_set1_epi64x( 0x0000000000000FFF );
+	const __m128i mask1 = _mm_set1_epi64x( 0x000000000FFF0000 );
+	const __m128i mask2 = _mm_set1_epi64x( 0x00000FFF00000000 );
+	const __m128i mask3 = _mm_set1_epi64x( 0x0FFF000000000000 );
+
+	for ( unsigned int sample = 0; sample < B12_DECODE_MIX_CHUNK_SIZE; sample += B12_DECODE_MIX_SAMPLES_PER_STEP )
+	{
+		// 6 bytes in each 64 bit lane, loaded as two overlapping halves so nothing past the 12 bytes is read
+		const __m128i bytes0To7 = _mm_loadl_epi64( reinterpret_cast<const __m128i*>(&compressed[0]) );
+		const __m128i bytes4To11 = _mm_loadl_epi64( reinterpret_cast<const __m128i*>(&compressed[4]) );
+		const __m128i packed = _mm_unpacklo_epi64( bytes0To7, _mm_srli_epi64(bytes4To11, 16) );
+
+		// each lane holds 4 samples 12 bits apart, shifting each one up to its own 16 bit lane unpacks the lot
+		const __m128i samples = _mm_or_si128( _mm_or_si128(_mm_and_si128(packed, mask0), _mm_and_si128(_mm_slli_epi64(packed, 4), mask1)),
+							_mm_or_si128(_mm_and_si128(_mm_slli_epi64(packed, 8), mask2),
+									_mm_and_si128(_mm_slli_epi64(packed, 12), mask3)) );
+
+		mixSamples<GAIN_L>( samples, &busL[sample], gainVecL );
+		mixSamples<GAIN_R>( samples, &busR[sample], gainVecR );
+
+		compressed += ( B12_DECODE_MIX_SAMPLES_PER_STEP * 3 ) / 2;
+	}
+}
+
+#else
+
+template <MixGain GAIN_L, MixGain GAIN_R>
+static inline void decodeMixChunk (const uint8_t* compressed, int32_t* busL, int32_t* busR, int16_t gainL, int16_t gainR)
+{
+	for ( unsigned int sample = 0; sample < B12_DECODE_MIX_CHUNK_SIZE; sample += 2 )
+	{
+		const uint16_t sample0 = compressed[0] | ( (compressed[1] & 0x0F) << 8 );
+		const uint16_t sample1 = ( compressed[1] >> 4 ) | ( compressed[2] << 4 );
+
+		if ( GAIN_L != MixGain::ZERO )
+		{
+			const int16_t gain = ( GAIN_L == MixGain::UNITY ) ? B12_DECODE_MIX_UNITY_GAIN : gainL;
+			busL[sample + 0] += scaleSample( sample0, gain );
+			busL[sample + 1] += scaleSample( sample1, gain );
+		}
+		if ( GAIN_R != MixGain::ZERO )
+		{
+			const int16_t gain = ( GAIN_R == MixGain::UNITY ) ? B12_DECODE_MIX_UNITY_GAIN : gainR;
+			busR[sample + 0] += scaleSample( sample0, gain );
+			busR[sample + 1] += scaleSample( sample1, gain );
+		}
+
+		compressed += 3;
+	}
+}
+
+#endif
+
+template <MixGain GAIN_L, MixGain GAIN_R>
+static void decodeMix (const uint8_t* compressed, unsigned int numSamples, int32_t* busL, int32_t* busR, int16_t gainL, int16_t gainR)
+{
+	for ( unsigned int sample = 0; sample < numSamples; sample += B12_DECODE_MIX_CHUNK_SIZE )
+	{
+		decodeMixChunk<GAIN_L, GAIN_R>( compressed, &busL[sample], &busR[sample], gainL, gainR );
+
+		compressed += B12_DECODE_MIX_CHUNK_SIZE_IN_BYTES;
+	}
+}
+
+template <MixGain GAIN_L, MixGain GAIN_R>
+static void decodeMixStereo (const uint8_t* compressed, unsigned int numFrames, int32_t* busL, int32_t* busR, int16_t gainL,
+				int16_t gainR)
+{
+	// a silent channel isn't even unpacked
+	for ( unsigned int frame = 0; frame < numFrames; frame += B12_DECODE_MIX_CHUNK_SIZE )
+	{
+		if ( GAIN_L != MixGain::ZERO )
+		{
+			decodeMixChunk<GAIN_L, MixGain::ZERO>( compressed, &busL[frame], &busR[frame], gainL, 0 );
+		}
+		compressed += B12_DECODE_MIX_CHUNK_SIZE_IN_BYTES;
+
+		if ( GAIN_R != MixGain::ZERO )
+		{
+			decodeMixChunk<MixGain::ZERO, GAIN_R>( compressed, &busL[frame], &busR[frame], 0, gainR );
+		}
+		compressed += B12_DECODE_MIX_CHUNK_SIZE_IN_BYTES;
+	}
+}
+
+// a silent mono track isn't even unpacked
+template <>
+void decodeMix<MixGain::ZERO, MixGain::ZERO> (const uint8_t*, unsigned int, int32_t*, int32_t*, int16_t, int16_t)
+{
+}
+
+// indexed by [MixGain of the left bus][MixGain of the right bus]
+static const B12DecodeMixFunction decodeMixVariants[NUM_MIX_GAINS][NUM_MIX_GAINS] =
+{
+	{ decodeMix<MixGain::ZERO, MixGain::ZERO>, decodeMix<MixGain::ZERO, MixGain::UNITY>, decodeMix<MixGain::ZERO, MixGain::GENERIC> },
+	{ decodeMix<MixGain::UNITY, MixGain::ZERO>, decodeMix<MixGain::UNITY, MixGain::UNITY>, decodeMix<MixGain::UNITY, MixGain::GENERIC> },
+	{ decodeMix<MixGain::GENERIC, MixGain::ZERO>, decodeMix<MixGain::GENERIC, MixGain::UNITY>,
+		decodeMix<MixGain::GENERIC, MixGain::GENERIC> }
+};
+
+static const B12DecodeMixFunction decodeMixStereoVariants[NUM_MIX_GAINS][NUM_MIX_GAINS] =
+{
+	{ decodeMixStereo<MixGain::ZERO, MixGain::ZERO>, decodeMixStereo<MixGain::ZERO, MixGain::UNITY>,
+		decodeMixStereo<MixGain::ZERO, MixGain::GENERIC> },
+	{ decodeMixStereo<MixGain::UNITY, MixGain::ZERO>, decodeMixStereo<MixGain::UNITY, MixGain::UNITY>,
+		decodeMixStereo<MixGain::UNITY, MixGain::GENERIC> },
+	{ decodeMixStereo<MixGain::GENERIC, MixGain::ZERO>, decodeMixStereo<MixGain::GENERIC, MixGain::UNITY>,
+		decodeMixStereo<MixGain::GENERIC, MixGain::GENERIC> }
+};
+
+B12DecodeMixFunction B12SelectDecodeMix (const int16_t gainL, const int16_t gainR, const bool interleavedStereo)
+{
+	const unsigned int gainLIndex = static_cast<unsigned int>( mixGainFor(gainL) );
+	const unsigned int gainRIndex = static_cast<unsigned int>( mixGainFor(gainR) );
+
+	return ( interleavedStereo ) ? decodeMixStereoVariants[gainLIndex][gainRIndex] : decodeMixVariants[gainLIndex][gainRIndex];
+}
+
+void B12DecodeMix (const uint8_t* compressed, unsigned int numSamples, int32_t* busL, int32_t* busR, int16_t gainL, int16_t gainR)
+{
+	decodeMix<MixGain::GENERIC, MixGain::GENERIC>( compressed, numSamples, busL, busR, gainL, gainR );
+}
+
+void B12DecodeMixStereo (const uint8_t* compressed, unsigned int numFrames, int32_t* busL, int32_t* busR, int16_t gainL,
+				int16_t gainR)
+{
+	decodeMixStereo<MixGain::GENERIC, MixGain::GENERIC>( compressed, numFrames, busL, busR, gainL, gainR );
+}
+
+void B12DecodeMixScalar (const uint8_t* compressed, unsigned int numSamples, int32_t* busL, int32_t* busR, int16_t gainL,
+				int16_t gainR)
+{
+	uint16_t samples[B12_DECODE_MIX_CHUNK_SIZE];
+
+	for ( unsigned int sample = 0; sample < numSamples; sample += B12_DECODE_MIX_CHUNK_SIZE )
+	{
+		B12Decompress( compressed, B12_DECODE_MIX_CHUNK_SIZE_IN_BYTES, samples, B12_DECODE_MIX_CHUNK_SIZE );
+		mixChunkScalar( samples, B12_DECODE_MIX_CHUNK_SIZE, &busL[sample], gainL );
+		mixChunkScalar( samples, B12_DECODE_MIX_CHUNK_SIZE, &busR[sample], gainR );
+
+		compressed += B12_DECODE_MIX_CHUNK_SIZE_IN_BYTES;
+	}
+}
@@ -0,0 +1,39 @@
+#include "BlockingStorageMedia.hpp"
+
+#include "IStorageMedia.hpp"
+#include "IReadIntoStorageMedia.hpp"
+#include "SharedData.hpp"
+#include <cstring>
+
+BlockingStorageMedia::BlockingStorageMedia (IStorageMedia& storageMedia, IReadIntoStorageMedia* readIntoMedia) :
+	m_StorageMedia( storageMedia ),
+	m_ReadIntoMedia( readIntoMedia )
+{
+}
+
+BlockingStorageMedia::~BlockingStorageMedia()
+{
+}
+
+unsigned int BlockingStorageMedia::submitRead (uint8_t* destination, unsigned int sizeInBytes, unsigned int byteAddress)
+{
+	if ( m_ReadIntoMedia )
+	{
+		m_ReadIntoMedia->readFromMediaInto( destination, sizeInBytes, byteAddress );
+	}
+	else
+	{
+		// IStorageMedia only hands back a buffer of its own, so the read is copied once into the destination
+		SharedData<uint8_t> data = m_StorageMedia.readFromMedia( sizeInBytes, byteAddress );
+		std::memcpy( destination, &data[0], sizeInBytes );
+	}
+
+	// the read is already done, so there is only ever one request id
+	return 0;
+}
+
+bool BlockingStorageMedia::pollRead (unsigned int /* requestId */)
+{
+	// every read finished when it was submitted
+	return true;
+}
@@ -0,0 +1,218 @@
+#include "Fat16DirectoryIndex.hpp"
+
+#include <string.h>
+#include <ctype.h>
+
+constexpr uint8_t FAT16_DIRECTORY_INDEX_SLOT_EMPTY = 0;
+constexpr uint8_t FAT16_DIRECTORY_INDEX_SLOT_USED = 1;
+constexpr uint8_t FAT16_DIRECTORY_INDEX_SLOT_REMOVED = 2;
+
+Fat16DirectoryIndex::Fat16DirectoryIndex() :
+	m_Allocator( nullptr ),
+	m_Slots(),
+	m_NumSlots( 0 ),
+	m_NumEntries( 0 ),
+	m_NumRemoved( 0 )
+{
+}
+
+Fat16DirectoryIndex::~Fat16DirectoryIndex()
+{
+}
+
+void Fat16DirectoryIndex::build (const std::vector<Fat16Entry*>& entries, IAllocator* allocator)
+{
+	m_Allocator = allocator;
+
+	// leave the table at most half full so there's room for new entries before it has to grow
+	unsigned int numSlots = FAT16_DIRECTORY_INDEX_MIN_SLOTS;
+	while ( numSlots < entries.size() * 2 )
+	{
+		numSlots *= 2;
+	}
+
+	m_NumSlots = 0;
+	this->rehash( numSlots );
+
+	unsigned int entryIndex = 0;
+	for ( const Fat16Entry* entry : entries )
+	{
+		if ( ! entry->isDeletedEntry() ) this->insert( *entry, entryIndex );
+
+		entryIndex++;
+	}
+}
+
+void Fat16DirectoryIndex::clear()
+{
+	for ( unsigned int slot = 0; slot < m_NumSlots; slot++ )
+	{
+		m_Slots[slot].m_State = FAT16_DIRECTORY_INDEX_SLOT_EMPTY;
+	}
+
+	m_NumEntries = 0;
+	m_NumRemoved = 0;
+}
+
+bool Fat16DirectoryIndex::find (const char* filenameDisplay, unsigned int& entryIndex, const char* extension) const
+{
+	char key[FAT16_DIRECTORY_INDEX_KEY_SIZE];
+	MakeKeyFromDisplay( filenameDisplay, extension, key );
+
+	unsigned int slotIndex = 0;
+	if ( ! this->findKey(key, slotIndex) ) return false;
+
+	entryIndex = m_Slots[slotIndex].m_EntryIndex;
+
+	return true;
+}
+
+bool Fat16DirectoryIndex::findRaw (const char* filenameRaw, const char* extensionRaw, unsigned int& entryIndex) const
+{
+	char key[FAT16_DIRECTORY_INDEX_KEY_SIZE];
+	MakeKeyFromRaw( filenameRaw, extensionRaw, key );
+
+	unsigned int slotIndex = 0;
+	if ( ! this->findKey(key, slotIndex) ) return false;
+
+	entryIndex = m_Slots[slotIndex].m_EntryIndex;
+
+	return true;
+}
+
+void Fat16DirectoryIndex::insert (const Fat16Entry& entry, unsigned int entryIndex)
+{
+	char key[FAT16_DIRECTORY_INDEX_KEY_SIZE];
+	MakeKeyFromRaw( entry.getFilenameRaw(), entry.getExtensionRaw(), key );
+
+	// an entry that is already indexed is only moved
+	unsigned int slotIndex = 0;
+	if ( this->findKey(key, slotIndex) )
+	{
+		m_Slots[slotIndex].m_EntryIndex = entryIndex;
+
+		return;
+	}
+
+	if ( (m_NumEntries + m_NumRemoved + 1) * 4 > m_NumSlots * 3 )
+	{
+		unsigned int numSlots = ( m_NumSlots > 0 ) ? m_NumSlots : FAT16_DIRECTORY_INDEX_MIN_SLOTS;
+		while ( (m_NumEntries + 1) * 2 > numSlots )
+		{
+			numSlots *= 2;
+		}
+
+		this->rehash( numSlots );
+	}
+
+	this->insertKey( key, entryIndex );
+}
+
+void Fat16DirectoryIndex::remove (const Fat16Entry& entry)
+{
+	char key[FAT16_DIRECTORY_INDEX_KEY_SIZE];
+	MakeKeyFromRaw( entry.getFilenameRaw(), entry.getExtensionRaw(), key );
+
+	unsigned int slotIndex = 0;
+	if ( ! this->findKey(key, slotIndex) ) return;
+
+	m_Slots[slotIndex].m_State = FAT16_DIRECTORY_INDEX_SLOT_REMOVED;
+	m_NumEntries--;
+	m_NumRemoved++;
+}
+
+void Fat16DirectoryIndex::insertKey (const char* key, unsigned int entryIndex)
+{
+	unsigned int slotIndex = Hash( key ) & ( m_NumSlots - 1 );
+	while ( m_Slots[slotIndex].m_State == FAT16_DIRECTORY_INDEX_SLOT_USED )
+	{
+		slotIndex = ( slotIndex + 1 ) & ( m_NumSlots - 1 );
+	}
+
+	if ( m_Slots[slotIndex].m_State == FAT16_DIRECTORY_INDEX_SLOT_REMOVED ) m_NumRemoved--;
+
+	memcpy( m_Slots[slotIndex].m_Key, key, FAT16_DIRECTORY_INDEX_KEY_SIZE );
+	m_Slots[slotIndex].m_State = FAT16_DIRECTORY_INDEX_SLOT_USED;
+	m_Slots[slotIndex].m_EntryIndex = entryIndex;
+	m_NumEntries++;
+}
+
+bool Fat16DirectoryIndex::findKey (const char* key, unsigned int& slotIndex) const
+{
+	if ( m_NumSlots == 0 ) return false;
+
+	// the table is never full, so the probe always ends at an empty slot
+	slotIndex = Hash( key ) & ( m_NumSlots - 1 );
+	while ( m_Slots[slotIndex].m_State != FAT16_DIRECTORY_INDEX_SLOT_EMPTY )
+	{
+		if ( m_Slots[slotIndex].m_State == FAT16_DIRECTORY_INDEX_SLOT_USED
+				&& memcmp(m_Slots[slotIndex].m_Key, key, FAT16_DIRECTORY_INDEX_KEY_SIZE) == 0 )
+		{
+			return true;
+		}
+
+		slotIndex = ( slotIndex + 1 ) & ( m_NumSlots - 1 );
+	}
+
+	return false;
+}
+
+void Fat16DirectoryIndex::rehash (unsigned int numSlots)
+{
+	SharedData<Fat16DirectoryIndexSlot> oldSlots = m_Slots;
+	const unsigned int oldNumSlots = m_NumSlots;
+
+	m_Slots = SharedData<Fat16DirectoryIndexSlot>::MakeSharedData( numSlots, m_Allocator );
+	m_NumSlots = numSlots;
+	this->clear();
+
+	for ( unsigned int slot = 0; slot < oldNumSlots; slot++ )
+	{
+		if ( oldSlots[slot].m_State == FAT16_DIRECTORY_INDEX_SLOT_USED )
+		{
+			this->insertKey( oldSlots[slot].m_Key, oldSlots[slot].m_EntryIndex );
+		}
+	}
+}
+
+void Fat16DirectoryIndex::MakeKeyFromDisplay (const char* filenameDisplay, const char* extension, char* key)
+{
+	memset( key, ' ', FAT16_DIRECTORY_INDEX_KEY_SIZE );
+
+	unsigned int character = 0;
+	for ( ; filenameDisplay[character] != '\0' && filenameDisplay[character] != '.'; character++ )
+	{
+		if ( character < FAT16_FILENAME_SIZE ) key[character] = toupper( filenameDisplay[character] );
+	}
+
+	if ( ! extension ) extension = ( filenameDisplay[character] == '.' ) ? &filenameDisplay[character + 1] : "";
+	for ( unsigned int extCharacter = 0; extCharacter < FAT16_EXTENSION_SIZE && extension[extCharacter] != '\0'; extCharacter++ )
+	{
+		key[FAT16_FILENAME_SIZE + extCharacter] = toupper( extension[extCharacter] );
+	}
+}
+
+void Fat16DirectoryIndex::MakeKeyFromRaw (const char* filenameRaw, const char* extensionRaw, char* key)
+{
+	for ( unsigned int character = 0; character < FAT16_FILENAME_SIZE; character++ )
+	{
+		key[character] = toupper( filenameRaw[character] );
+	}
+
+	for ( unsigned int character = 0; character < FAT16_EXTENSION_SIZE; character++ )
+	{
+		key[FAT16_FILENAME_SIZE + character] = toupper( extensionRaw[character] );
+	}
+}
+
+uint32_t Fat16DirectoryIndex::Hash (const char* key)
+{
+	// fnv-1a
+	uint32_t hash = 2166136261u;
+	for ( unsigned int character = 0; character < FAT16_DIRECTORY_INDEX_KEY_SIZE; character++ )
+	{
+		hash = ( hash ^ static_cast<uint8_t>(key[character]) ) * 16777619u;
+	}
+
+	return hash;
+}
@@ -0,0 +1,333 @@
+#include "Fat16SectorStream.hpp"
+
+#include "IStorageMedia.hpp"
+#include "Fat16FileManager.hpp"
+#include "Fat16Entry.hpp" // for FAT16_FILENAME_SIZE and FAT16_EXTENSION_SIZE
+#include <string.h>
+#include <limits>
+
+constexpr unsigned int FAT16_MBR_SECTOR_SIZE = 512;
+constexpr unsigned int FAT16_MBR_PARTITION1_LBA_OFFSET = 0x1C6;
+constexpr unsigned int FAT16_DIRECTORY_ENTRY_SIZE = 32;
+constexpr unsigned int FAT16_FIRST_DATA_CLUSTER = 2;
+constexpr unsigned int FAT16_BAD_CLUSTER = 0xFFF7; // anything from here up is a bad cluster or the end of the chain
+constexpr uint8_t      FAT16_ENTRY_END_OF_DIRECTORY = 0x00;
+constexpr uint8_t      FAT16_ENTRY_DELETED = 0xE5;
+constexpr uint8_t      FAT16_ATTRIBUTE_LONG_FILENAME = 0x0F;
+constexpr uint8_t      FAT16_ATTRIBUTE_VOLUME_LABEL = 0x08;
+
+static unsigned int readU16 (SharedData<uint8_t>& data, unsigned int offset)
+{
+	return data[offset] | data[offset + 1] << 8;
+}
+
+static unsigned int readU32 (SharedData<uint8_t>& data, unsigned int offset)
+{
+	return data[offset] | data[offset + 1] << 8 | data[offset + 2] << 16 | data[offset + 3] << 24;
+}
+
+Fat16SectorStream::Fat16SectorStream (IStorageMedia& storageMedia, const Fat16Geometry& geometry, unsigned int startingCluster,
+					unsigned int fileSizeInBytes) :
+	m_StorageMedia( &storageMedia ),
+	m_Geometry( geometry ),
+	m_StartingCluster( startingCluster ),
+	m_FileSizeInBytes( fileSizeInBytes ),
+	m_FileSizeInSectors( (startingCluster >= FAT16_FIRST_DATA_CLUSTER)
+				? (fileSizeInBytes + geometry.m_SectorSizeInBytes - 1) / geometry.m_SectorSizeInBytes : 0 ),
+	m_DataOffsetInSectors( 0 ),
+	m_CurrentCluster( startingCluster ),
+	m_SectorInCluster( 0 ),
+	m_SectorsRead( 0 ),
+	m_FatSectorCache( SharedData<uint8_t>::MakeSharedData(geometry.m_SectorSizeInBytes) ),
+	m_FatSectorCacheNum( std::numeric_limits<unsigned int>::max() ), // so the first lookup reads from the media
+	m_Extents(),
+	m_NumExtents( 0 ),
+	m_CurrentExtent( 0 ),
+	m_ClusterInExtent( 0 )
+{
+}
+
+Fat16SectorStream::~Fat16SectorStream()
+{
+}
+
+unsigned int Fat16SectorStream::getStartingAddress() const
+{
+	const unsigned int clusterSizeInBytes = m_Geometry.m_SectorsPerCluster * m_Geometry.m_SectorSizeInBytes;
+
+	return m_Geometry.m_DataAddress + ( (m_StartingCluster - FAT16_FIRST_DATA_CLUSTER) * clusterSizeInBytes );
+}
+
+void Fat16SectorStream::setDataOffset (unsigned int numSectors)
+{
+	m_DataOffsetInSectors = ( numSectors < m_FileSizeInSectors ) ? numSectors : m_FileSizeInSectors;
+
+	this->rewind();
+}
+
+unsigned int Fat16SectorStream::getDataSizeInBytes() const
+{
+	const unsigned int offsetInBytes = m_DataOffsetInSectors * m_Geometry.m_SectorSizeInBytes;
+
+	return ( m_FileSizeInBytes > offsetInBytes ) ? m_FileSizeInBytes - offsetInBytes : 0;
+}
+
+void Fat16SectorStream::rewind()
+{
+	m_CurrentCluster = m_StartingCluster;
+	m_SectorInCluster = 0;
+	m_SectorsRead = 0;
+	m_CurrentExtent = 0;
+	m_ClusterInExtent = 0;
+
+	this->advance( m_DataOffsetInSectors );
+}
+
+unsigned int Fat16SectorStream::nextSectorRun (unsigned int maxSectors, unsigned int& byteAddress)
+{
+	const unsigned int sectorsRemainingInFile = m_FileSizeInSectors - m_SectorsRead;
+	const unsigned int maxSectorsToRead = ( maxSectors < sectorsRemainingInFile ) ? maxSectors : sectorsRemainingInFile;
+
+	// the rest of the current cluster can always be read, then extend the read for as long as the chain stays contiguous
+	unsigned int numSectors = m_Geometry.m_SectorsPerCluster - m_SectorInCluster;
+	if ( m_NumExtents > 0 )
+	{
+		const unsigned int clustersLeftInExtent = m_Extents[m_CurrentExtent].m_NumClusters - m_ClusterInExtent - 1;
+		numSectors += clustersLeftInExtent * m_Geometry.m_SectorsPerCluster;
+	}
+	else
+	{
+		unsigned int cluster = m_CurrentCluster;
+		while ( numSectors < maxSectorsToRead && this->getNextCluster(cluster) == cluster + 1 )
+		{
+			cluster++;
+			numSectors += m_Geometry.m_SectorsPerCluster;
+		}
+	}
+	numSectors = ( numSectors < maxSectorsToRead ) ? numSectors : maxSectorsToRead;
+
+	const unsigned int clusterSizeInBytes = m_Geometry.m_SectorsPerCluster * m_Geometry.m_SectorSizeInBytes;
+	byteAddress = m_Geometry.m_DataAddress + ( (m_CurrentCluster - FAT16_FIRST_DATA_CLUSTER) * clusterSizeInBytes )
+				+ ( m_SectorInCluster * m_Geometry.m_SectorSizeInBytes );
+
+	return numSectors;
+}
+
+void Fat16SectorStream::advance (unsigned int numSectors)
+{
+	m_SectorsRead += numSectors;
+	m_SectorInCluster += numSectors;
+
+	// only follow the chain while there is still file left, the last cluster points to the end of chain marker
+	while ( m_SectorInCluster >= m_Geometry.m_SectorsPerCluster && ! this->isFinished() )
+	{
+		m_SectorInCluster -= m_Geometry.m_SectorsPerCluster;
+		m_CurrentCluster = this->followChain();
+
+		// a broken chain ends the file early rather than reading whatever a bad cluster number points at
+		if ( m_CurrentCluster < FAT16_FIRST_DATA_CLUSTER || m_CurrentCluster >= FAT16_BAD_CLUSTER )
+		{
+			m_SectorsRead = m_FileSizeInSectors;
+		}
+	}
+}
+
+bool Fat16SectorStream::buildExtentMap (IAllocator* allocator)
+{
+	const unsigned int fileSizeInClusters = this->getFileSizeInClusters();
+	if ( fileSizeInClusters == 0 ) return false;
+
+	// count the extents first so the map can be allocated at its exact size, stopping at anything that isn't a data cluster
+	unsigned int numExtents = 1;
+	unsigned int cluster = m_StartingCluster;
+	for ( unsigned int clusterNum = 1; clusterNum < fileSizeInClusters; clusterNum++ )
+	{
+		const unsigned int nextCluster = this->getNextCluster( cluster );
+		if ( nextCluster < FAT16_FIRST_DATA_CLUSTER || nextCluster >= FAT16_BAD_CLUSTER ) return false;
+
+		if ( nextCluster != cluster + 1 ) numExtents++;
+		cluster = nextCluster;
+	}
+
+	SharedData<Fat16Extent> extents = SharedData<Fat16Extent>::MakeSharedData( numExtents, allocator );
+	unsigned int extent = 0;
+	extents[extent].m_StartingCluster = m_StartingCluster;
+	extents[extent].m_NumClusters = 1;
+	cluster = m_StartingCluster;
+	for ( unsigned int clusterNum = 1; clusterNum < fileSizeInClusters; clusterNum++ )
+	{
+		const unsigned int nextCluster = this->getNextCluster( cluster );
+		if ( nextCluster == cluster + 1 )
+		{
+			extents[extent].m_NumClusters++;
+		}
+		else
+		{
+			extent++;
+			extents[extent].m_StartingCluster = nextCluster;
+			extents[extent].m_NumClusters = 1;
+		}
+
+		cluster = nextCluster;
+	}
+
+	m_Extents = extents;
+	m_NumExtents = numExtents;
+	this->rewind();
+
+	return true;
+}
+
+unsigned int Fat16SectorStream::followChain()
+{
+	if ( m_NumExtents == 0 ) return this->getNextCluster( m_CurrentCluster );
+
+	m_ClusterInExtent++;
+	if ( m_ClusterInExtent >= m_Extents[m_CurrentExtent].m_NumClusters && m_CurrentExtent + 1 < m_NumExtents )
+	{
+		m_CurrentExtent++;
+		m_ClusterInExtent = 0;
+	}
+
+	return m_Extents[m_CurrentExtent].m_StartingCluster + m_ClusterInExtent;
+}
+
+unsigned int Fat16SectorStream::getFileSizeInClusters() const
+{
+	if ( m_Geometry.m_SectorsPerCluster == 0 ) return 0;
+
+	return ( m_FileSizeInSectors + m_Geometry.m_SectorsPerCluster - 1 ) / m_Geometry.m_SectorsPerCluster;
+}
+
+unsigned int Fat16SectorStream::getNextCluster (unsigned int cluster)
+{
+	const unsigned int fatOffset = cluster * 2;
+	const unsigned int fatSectorNum = fatOffset / m_Geometry.m_SectorSizeInBytes;
+	if ( fatSectorNum != m_FatSectorCacheNum )
+	{
+		m_FatSectorCache = m_StorageMedia->readFromMedia( m_Geometry.m_SectorSizeInBytes,
+									m_Geometry.m_FatAddress + (fatSectorNum * m_Geometry.m_SectorSizeInBytes) );
+		m_FatSectorCacheNum = fatSectorNum;
+	}
+
+	return readU16( m_FatSectorCache, fatOffset % m_Geometry.m_SectorSizeInBytes );
+}
+
+Fat16Geometry Fat16SectorStream::GetGeometry (IStorageMedia& storageMedia, Fat16FileManager& fileManager)
+{
+	Fat16Geometry geometry;
+
+	const BootSector* bootSector = fileManager.getActiveBootSector();
+	if ( ! fileManager.isValidFatFileSystem() || ! bootSector ) return geometry;
+
+	// the first sector is either the boot sector itself or a master boot record pointing to the first partition
+	unsigned int partitionAddress = 0;
+	SharedData<uint8_t> sector = storageMedia.readFromMedia( FAT16_MBR_SECTOR_SIZE, 0 );
+	if ( sector[0] != 0xEB && sector[0] != 0xE9 )
+	{
+		partitionAddress = readU32( sector, FAT16_MBR_PARTITION1_LBA_OFFSET ) * FAT16_MBR_SECTOR_SIZE;
+		sector = storageMedia.readFromMedia( FAT16_MBR_SECTOR_SIZE, partitionAddress );
+	}
+
+	const unsigned int sectorSizeInBytes = readU16( sector, 0x0B );
+	const unsigned int sectorsPerCluster = sector[0x0D];
+	const unsigned int numReservedSectors = readU16( sector, 0x0E );
+	const unsigned int numFats = sector[0x10];
+	const unsigned int numRootDirectoryEntries = readU16( sector, 0x11 );
+	const unsigned int sectorsPerFat = readU16( sector, 0x16 );
+
+	// anything that doesn't agree with the boot sector the file manager mounted isn't the volume it is reading
+	if ( sectorSizeInBytes != bootSector->getSectorSizeInBytes() || sectorsPerCluster == 0 || numFats == 0 || sectorsPerFat == 0
+			|| sector[0x1FE] != 0x55 || sector[0x1FF] != 0xAA )
+	{
+		return geometry;
+	}
+
+	const unsigned int rootDirectorySizeInBytes = numRootDirectoryEntries * FAT16_DIRECTORY_ENTRY_SIZE;
+	const unsigned int rootDirectorySizeInSectors = ( rootDirectorySizeInBytes + sectorSizeInBytes - 1 ) / sectorSizeInBytes;
+
+	geometry.m_SectorSizeInBytes = sectorSizeInBytes;
+	geometry.m_SectorsPerCluster = sectorsPerCluster;
+	geometry.m_FatAddress = partitionAddress + ( numReservedSectors * sectorSizeInBytes );
+	geometry.m_RootDirectoryAddress = geometry.m_FatAddress + ( numFats * sectorsPerFat * sectorSizeInBytes );
+	geometry.m_RootDirectoryNumEntries = numRootDirectoryEntries;
+	geometry.m_DataAddress = geometry.m_RootDirectoryAddress + ( rootDirectorySizeInSectors * sectorSizeInBytes );
+	geometry.m_IsValid = sectorSizeInBytes > 0;
+
+	return geometry;
+}
+
+unsigned int Fat16SectorStream::FindStartingCluster (IStorageMedia& storageMedia, const Fat16Geometry& geometry,
+							unsigned int directoryCluster, const char* filenameRaw,
+							const char* extensionRaw)
+{
+	if ( ! geometry.m_IsValid ) return 0;
+
+	const unsigned int sectorSizeInBytes = geometry.m_SectorSizeInBytes;
+	bool endOfDirectory = false;
+
+	if ( directoryCluster == 0 )
+	{
+		// the root directory is a fixed region before the data clusters
+		const unsigned int rootDirectorySizeInBytes = geometry.m_RootDirectoryNumEntries * FAT16_DIRECTORY_ENTRY_SIZE;
+		for ( unsigned int offset = 0; offset < rootDirectorySizeInBytes && ! endOfDirectory; offset += sectorSizeInBytes )
+		{
+			SharedData<uint8_t> sector = storageMedia.readFromMedia( sectorSizeInBytes, geometry.m_RootDirectoryAddress + offset );
+			const unsigned int cluster = FindStartingClusterInSector( sector, sectorSizeInBytes, filenameRaw, extensionRaw,
+											endOfDirectory );
+			if ( cluster != 0 ) return cluster;
+		}
+
+		return 0;
+	}
+
+	// subdirectories are regular cluster chains
+	const unsigned int clusterSizeInBytes = geometry.m_SectorsPerCluster * sectorSizeInBytes;
+	unsigned int cluster = directoryCluster;
+	while ( cluster >= FAT16_FIRST_DATA_CLUSTER && cluster < FAT16_BAD_CLUSTER && ! endOfDirectory )
+	{
+		const unsigned int clusterAddress = geometry.m_DataAddress + ( (cluster - FAT16_FIRST_DATA_CLUSTER) * clusterSizeInBytes );
+		for ( unsigned int offset = 0; offset < clusterSizeInBytes && ! endOfDirectory; offset += sectorSizeInBytes )
+		{
+			SharedData<uint8_t> sector = storageMedia.readFromMedia( sectorSizeInBytes, clusterAddress + offset );
+			const unsigned int startingCluster = FindStartingClusterInSector( sector, sectorSizeInBytes, filenameRaw, extensionRaw,
+												endOfDirectory );
+			if ( startingCluster != 0 ) return startingCluster;
+		}
+
+		SharedData<uint8_t> fatEntry = storageMedia.readFromMedia( 2, geometry.m_FatAddress + (cluster * 2) );
+		cluster = readU16( fatEntry, 0 );
+	}
+
+	return 0;
+}
+
+unsigned int Fat16SectorStream::FindStartingClusterInSector (SharedData<uint8_t>& sector, unsigned int sectorSizeInBytes,
+								const char* filenameRaw, const char* extensionRaw,
+								bool& endOfDirectory)
+{
+	for ( unsigned int entryOffset = 0; entryOffset < sectorSizeInBytes; entryOffset += FAT16_DIRECTORY_ENTRY_SIZE )
+	{
+		const uint8_t firstByte = sector[entryOffset];
+		const uint8_t attributes = sector[entryOffset + 11];
+		if ( firstByte == FAT16_ENTRY_END_OF_DIRECTORY )
+		{
+			endOfDirectory = true;
+			return 0;
+		}
+		else if ( firstByte == FAT16_ENTRY_DELETED || attributes == FAT16_ATTRIBUTE_LONG_FILENAME
+				|| (attributes & FAT16_ATTRIBUTE_VOLUME_LABEL) )
+		{
+			continue;
+		}
+
+		const char* entryBytes = reinterpret_cast<const char*>( &sector[entryOffset] );
+		if ( strncmp(entryBytes, filenameRaw, FAT16_FILENAME_SIZE) == 0
+				&& strncmp(entryBytes + FAT16_FILENAME_SIZE, extensionRaw, FAT16_EXTENSION_SIZE) == 0 )
+		{
+			return readU16( sector, entryOffset + 26 );
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,47 @@
+#include "LoopCalendar.hpp"
+
+// the block counter wraps around, so blocks are compared by their distance rather than their value
+static inline bool IsBefore (const uint32_t block, const uint32_t otherBlock)
+{
+	return static_cast<int32_t>( block - otherBlock ) < 0;
+}
+
+LoopCalendar::LoopCalendar() :
+	m_Boundaries(),
+	m_NumBoundaries( 0 )
+{
+}
+
+LoopCalendar::~LoopCalendar()
+{
+}
+
+bool LoopCalendar::schedule (const uint32_t block, const LoopTrackType trackType, const unsigned int trackIndex)
+{
+	if ( m_NumBoundaries == MNEMONIC_LOOP_CALENDAR_SIZE ) return false;
+
+	// shift the earlier boundaries up to make room, boundaries on the same block keep the order they were scheduled in
+	unsigned int position = m_NumBoundaries;
+	while ( position > 0 && ! IsBefore(block, m_Boundaries[position - 1].m_Block) )
+	{
+		m_Boundaries[position] = m_Boundaries[position - 1];
+		position--;
+	}
+
+	m_Boundaries[position].m_Block = block;
+	m_Boundaries[position].m_TrackType = trackType;
+	m_Boundaries[position].m_TrackIndex = trackIndex;
+	m_NumBoundaries++;
+
+	return true;
+}
+
+bool LoopCalendar::popDue (const uint32_t block, LoopBoundary& boundary)
+{
+	if ( m_NumBoundaries == 0 || IsBefore(block, m_Boundaries[m_NumBoundaries - 1].m_Block) ) return false;
+
+	m_NumBoundaries--;
+	boundary = m_Boundaries[m_NumBoundaries];
+
+	return true;
+}
@@ -0,0 +1,115 @@
+#include "MasterLimiter.hpp"
+
+constexpr unsigned int MASTER_LIMITER_NUM_SEGMENTS = ABUFFER_SIZE / MASTER_LIMITER_LOOKAHEAD;
+
+static inline int32_t absolute (const int32_t value)
+{
+	return ( value < 0 ) ? -value : value;
+}
+
+static inline int16_t clampToDac (const int32_t value)
+{
+	if ( value > MASTER_LIMITER_THRESHOLD ) return MASTER_LIMITER_THRESHOLD;
+	if ( value < -MASTER_LIMITER_THRESHOLD - 1 ) return -MASTER_LIMITER_THRESHOLD - 1;
+
+	return static_cast<int16_t>( value );
+}
+
+MasterLimiter::MasterLimiter() :
+	m_DelayL{ 0 },
+	m_DelayR{ 0 },
+	m_DelayPeak( 0 ),
+	m_Gain( MASTER_LIMITER_UNITY_GAIN )
+{
+}
+
+MasterLimiter::~MasterLimiter()
+{
+}
+
+void MasterLimiter::reset()
+{
+	for ( unsigned int sample = 0; sample < MASTER_LIMITER_LOOKAHEAD; sample++ )
+	{
+		m_DelayL[sample] = 0;
+		m_DelayR[sample] = 0;
+	}
+
+	m_DelayPeak = 0;
+	m_Gain = MASTER_LIMITER_UNITY_GAIN;
+}
+
+void MasterLimiter::process (const int32_t* mixBusL, const int32_t* mixBusR, int16_t* writeBufferL, int16_t* writeBufferR)
+{
+	// stereo linked peak of every segment of the incoming block
+	int32_t segmentPeaks[MASTER_LIMITER_NUM_SEGMENTS];
+	for ( unsigned int segment = 0; segment < MASTER_LIMITER_NUM_SEGMENTS; segment++ )
+	{
+		int32_t peak = 0;
+		for ( unsigned int sample = segment * MASTER_LIMITER_LOOKAHEAD; sample < (segment + 1) * MASTER_LIMITER_LOOKAHEAD; sample++ )
+		{
+			const int32_t peakL = absolute( mixBusL[sample] );
+			const int32_t peakR = absolute( mixBusR[sample] );
+			peak = ( peakL > peak ) ? peakL : peak;
+			peak = ( peakR > peak ) ? peakR : peak;
+		}
+
+		segmentPeaks[segment] = peak;
+	}
+
+	// the delayed segment goes out first, then every incoming segment but the last, which becomes the new delay
+	int32_t currentPeak = m_DelayPeak;
+	const int32_t* inL = m_DelayL;
+	const int32_t* inR = m_DelayR;
+	for ( unsigned int segment = 0; segment < MASTER_LIMITER_NUM_SEGMENTS; segment++ )
+	{
+		const int32_t nextPeak = segmentPeaks[segment];
+		const int32_t peak = ( currentPeak > nextPeak ) ? currentPeak : nextPeak;
+		const unsigned int outOffset = segment * MASTER_LIMITER_LOOKAHEAD;
+
+		this->processSegment( inL, inR, &writeBufferL[outOffset], &writeBufferR[outOffset], this->targetGainForPeak(peak) );
+
+		currentPeak = nextPeak;
+		inL = &mixBusL[outOffset];
+		inR = &mixBusR[outOffset];
+	}
+
+	for ( unsigned int sample = 0; sample < MASTER_LIMITER_LOOKAHEAD; sample++ )
+	{
+		m_DelayL[sample] = inL[sample];
+		m_DelayR[sample] = inR[sample];
+	}
+	m_DelayPeak = currentPeak;
+}
+
+int32_t MasterLimiter::targetGainForPeak (const int32_t peak) const
+{
+	int32_t targetGain = MASTER_LIMITER_UNITY_GAIN;
+	if ( peak > MASTER_LIMITER_THRESHOLD )
+	{
+		targetGain = static_cast<int32_t>( (static_cast<int64_t>(MASTER_LIMITER_THRESHOLD) << 16) / peak );
+	}
+
+	// attack immediately, since the target already has to hold for this segment, but release slowly
+	if ( targetGain > m_Gain )
+	{
+		targetGain = m_Gain + ( (targetGain - m_Gain) >> MASTER_LIMITER_RELEASE_SHIFT );
+	}
+
+	return targetGain;
+}
+
+void MasterLimiter::processSegment (const int32_t* inL, const int32_t* inR, int16_t* outL, int16_t* outR, const int32_t targetGain)
+{
+	// both ends of the ramp are below threshold / peak for this segment, so every gain in between is as well
+	const int32_t gainStep = ( targetGain - m_Gain ) / static_cast<int32_t>( MASTER_LIMITER_LOOKAHEAD );
+	int32_t gain = m_Gain;
+	for ( unsigned int sample = 0; sample < MASTER_LIMITER_LOOKAHEAD; sample++ )
+	{
+		gain += gainStep;
+		outL[sample] += clampToDac( static_cast<int32_t>((static_cast<int64_t>(inL[sample]) * gain) >> 16) );
+		outR[sample] += clampToDac( static_cast<int32_t>((static_cast<int64_t>(inR[sample]) * gain) >> 16) );
+	}
+
+	m_Gain = targetGain;
+}
@@ -0,0 +1,48 @@
+#include "MidiOutputQueue.hpp"
+
+MidiOutputQueue::MidiOutputQueue() :
+	m_Bytes(),
+	m_RunningStatus( 0 )
+{
+}
+
+MidiOutputQueue::~MidiOutputQueue()
+{
+}
+
+static inline bool IsChannelStatus (const uint8_t status)
+{
+	return status >= 0x80 && status < 0xF0;
+}
+
+bool MidiOutputQueue::writeEvent (const MidiEvent& midiEvent)
+{
+	const unsigned int numBytes = midiEvent.getNumBytes();
+	if ( numBytes == 0 ) return true;
+
+	const uint8_t* rawData = midiEvent.getRawData();
+	const uint8_t status = rawData[0];
+
+	if ( m_Bytes.isEmpty() ) m_RunningStatus = 0;
+	const unsigned int firstByteNum = ( IsChannelStatus(status) && status == m_RunningStatus ) ? 1 : 0;
+	if ( m_Bytes.capacity() - m_Bytes.size() < numBytes - firstByteNum ) return false;
+
+	for ( unsigned int byteNum = firstByteNum; byteNum < numBytes; byteNum++ )
+	{
+		m_Bytes.push( rawData[byteNum] );
+	}
+
+	// system messages cancel running status, except for real time messages which can go anywhere
+	if ( IsChannelStatus(status) )
+	{
+		m_RunningStatus = status;
+	}
+	else if ( status < 0xF8 )
+	{
+		m_RunningStatus = 0;
+	}
+
+	this->onBytesWritten();
+
+	return true;
+}
@@ -0,0 +1,128 @@
+#include "MidiOutputScheduler.hpp"
+
+#include "MidiOutputQueue.hpp"
+
+// the sample clock wraps around, so times are compared by their distance rather than their value
+static inline bool IsBefore (const uint32_t sampleTime, const uint32_t otherSampleTime)
+{
+	return static_cast<int32_t>( sampleTime - otherSampleTime ) < 0;
+}
+
+static inline bool IsNoteOff (const MidiEvent& midiEvent)
+{
+	const uint8_t* rawData = midiEvent.getRawData();
+	const uint8_t messageType = rawData[0] & 0xF0;
+
+	// a note on with a velocity of 0 is a note off too
+	return midiEvent.getNumBytes() == 3 && ( messageType == 0x80 || (messageType == 0x90 && rawData[2] == 0) );
+}
+
+// whether both are note ons or offs for the same note on the same channel, which must never be reordered
+static inline bool IsSameNote (const MidiEvent& midiEvent, const MidiEvent& otherMidiEvent)
+{
+	const uint8_t* rawData = midiEvent.getRawData();
+	const uint8_t* otherRawData = otherMidiEvent.getRawData();
+	const uint8_t messageType = rawData[0] & 0xF0;
+	const uint8_t otherMessageType = otherRawData[0] & 0xF0;
+
+	return midiEvent.getNumBytes() == 3 && otherMidiEvent.getNumBytes() == 3
+		&& ( messageType == 0x80 || messageType == 0x90 ) && ( otherMessageType == 0x80 || otherMessageType == 0x90 )
+		&& ( rawData[0] & 0x0F ) == ( otherRawData[0] & 0x0F ) && rawData[1] == otherRawData[1];
+}
+
+// whether a note off can go ahead of another event, so that notes stop first when the wire is saturated
+static inline bool CanGoAhead (const MidiEvent& midiEvent, const MidiEvent& otherMidiEvent)
+{
+	return IsNoteOff( midiEvent ) && ! IsNoteOff( otherMidiEvent ) && ! IsSameNote( midiEvent, otherMidiEvent );
+}
+
+MidiOutputScheduler::MidiOutputScheduler() :
+	m_Scheduled(),
+	m_Pending(),
+	m_NumPending( 0 ),
+	m_NumDropped( 0 )
+{
+}
+
+MidiOutputScheduler::~MidiOutputScheduler()
+{
+}
+
+bool MidiOutputScheduler::schedule (const TimedMidiEvent& timedMidiEvent)
+{
+	if ( m_Scheduled.push(timedMidiEvent) ) return true;
+
+	m_NumDropped++;
+
+	return false;
+}
+
+void MidiOutputScheduler::addPending (const TimedMidiEvent& timedMidiEvent)
+{
+	// shift the earlier events up to make room, events due at the same sample keep the order they were scheduled in
+	unsigned int position = m_NumPending;
+	while ( position > 0 && ! IsBefore(timedMidiEvent.m_SampleTime, m_Pending[position - 1].m_SampleTime) )
+	{
+		m_Pending[position] = m_Pending[position - 1];
+		position--;
+	}
+
+	// except that a note off goes ahead of the events due at the same sample, for as long as it can
+	while ( position < m_NumPending && m_Pending[position + 1].m_SampleTime == timedMidiEvent.m_SampleTime
+			&& CanGoAhead(timedMidiEvent.m_MidiEvent, m_Pending[position + 1].m_MidiEvent) )
+	{
+		m_Pending[position] = m_Pending[position + 1];
+		position++;
+	}
+
+	m_Pending[position] = timedMidiEvent;
+	m_NumPending++;
+}
+
+void MidiOutputScheduler::release (uint32_t sampleTime, MidiOutputQueue& outputQueue)
+{
+	// take in what was scheduled since the last release, as long as there's room to hold it
+	TimedMidiEvent timedMidiEvent;
+	while ( m_NumPending < MIDI_OUTPUT_SCHEDULER_SIZE && m_Scheduled.pop(timedMidiEvent) )
+	{
+		this->addPending( timedMidiEvent );
+	}
+
+	// the due events are the earliest, at the end
+	unsigned int numDue = 0;
+	while ( numDue < m_NumPending && ! IsBefore(sampleTime, m_Pending[m_NumPending - 1 - numDue].m_SampleTime) )
+	{
+		numDue++;
+	}
+
+	while ( numDue > 0 && outputQueue.getNumBytesQueued() < MIDI_OUTPUT_SCHEDULER_MAX_BYTES_QUEUED )
+	{
+		// if the wire has fallen behind, the due note offs go first, ahead of anything but the same note
+		unsigned int eventNum = m_NumPending - 1;
+		if ( numDue > 1 && ! IsNoteOff(m_Pending[eventNum].m_MidiEvent) )
+		{
+			for ( unsigned int noteOffNum = m_NumPending - 1; noteOffNum-- > m_NumPending - numDue; )
+			{
+				if ( ! IsNoteOff(m_Pending[noteOffNum].m_MidiEvent) ) continue;
+
+				bool canGoAhead = true;
+				for ( unsigned int aheadNum = noteOffNum + 1; aheadNum < m_NumPending && canGoAhead; aheadNum++ )
+				{
+					canGoAhead = CanGoAhead( m_Pending[noteOffNum].m_MidiEvent, m_Pending[aheadNum].m_MidiEvent );
+				}
+				if ( canGoAhead ) eventNum = noteOffNum;
+
+				break;
+			}
+		}
+
+		if ( ! outputQueue.writeEvent(m_Pending[eventNum].m_MidiEvent) ) return;
+
+		for ( ; eventNum < m_NumPending - 1; eventNum++ )
+		{
+			m_Pending[eventNum] = m_Pending[eventNum + 1];
+		}
+		m_NumPending--;
+		numDue--;
+	}
+}
@@ -0,0 +1,78 @@
+#include "MidiSampleClock.hpp"
+
+MidiSampleClock::MidiSampleClock() :
+	m_SampleCount( 0 ),
+	m_Timestamps(),
+	m_RunningStatus( 0 ),
+	m_DataBytesLeft( 0 ),
+	m_MessageStart( 0 )
+{
+}
+
+MidiSampleClock::~MidiSampleClock()
+{
+}
+
+static unsigned int dataBytesForStatus (uint8_t status)
+{
+	// program change and channel pressure have one data byte, every other channel message has two
+	const uint8_t messageType = status & 0xF0;
+	return ( messageType == 0xC0 || messageType == 0xD0 ) ? 1 : 2;
+}
+
+void MidiSampleClock::onByteReceived (uint8_t byte)
+{
+	if ( byte >= 0xF8 ) return; // real time messages can land anywhere, even inside other messages
+
+	if ( byte >= 0xF0 )
+	{
+		// system common and system exclusive messages cancel running status
+		m_RunningStatus = 0;
+		m_DataBytesLeft = 0;
+
+		return;
+	}
+
+	const uint32_t sampleCount = this->getSampleCount();
+	if ( byte >= 0x80 )
+	{
+		m_RunningStatus = byte;
+		m_DataBytesLeft = dataBytesForStatus( byte );
+		m_MessageStart = sampleCount;
+
+		return;
+	}
+
+	if ( m_RunningStatus == 0 ) return;
+
+	if ( m_DataBytesLeft == 0 )
+	{
+		// a new message under running status starts with its first data byte
+		m_DataBytesLeft = dataBytesForStatus( m_RunningStatus );
+		m_MessageStart = sampleCount;
+	}
+
+	m_DataBytesLeft--;
+	if ( m_DataBytesLeft == 0 )
+	{
+		// if the ring is full the message goes without a timestamp, and is timed when it's dispatched instead
+		m_Timestamps.push( MidiTimestamp{m_RunningStatus, m_MessageStart} );
+	}
+}
+
+bool MidiSampleClock::popTimestamp (uint8_t status, uint32_t& sampleCount)
+{
+	// look for the oldest timestamp with this status, the ones before it are for messages that were never dispatched
+	for ( unsigned int timestampNum = 0; const MidiTimestamp* timestamp = m_Timestamps.peek(timestampNum); timestampNum++ )
+	{
+		if ( timestamp->m_Status == status )
+		{
+			sampleCount = timestamp->m_SampleCount;
+			m_Timestamps.drop( timestampNum + 1 );
+
+			return true;
+		}
+	}
+
+	return false;
+}
@@ -1,5 +1,7 @@
 #include "MidiTrack.hpp"
 
+#include "MnemonicProfiler.hpp"
+
 #include <string.h>
 
 MidiTrack::MidiTrack (unsigned int cellX, unsigned int cellY, const MidiTrackEvent* const midiTrackEvents,
@@ -9,8 +11,8 @@ MidiTrack::MidiTrack (unsigned int cellX, unsigned int cellY, const MidiTrackEve
 	m_CellY( cellY ),
 	m_MidiTrackEvents( SharedData<MidiTrackEvent>::MakeSharedData(lengthInMidiTrackEvents, &allocator) ),
 	m_LengthInMidiTrackEvents( lengthInMidiTrackEvents ),
-	m_LoopEndInBlocks( loopEnd ),
-	m_MidiTrackEventsIndex( 0 ),
+	m_LoopEndInBlocks( (loopEnd > 0) ? loopEnd : 1 ),
+	m_BlockOffsets( SharedData<uint16_t>::MakeSharedData(m_LoopEndInBlocks + 1, &allocator) ),
 	m_IsSaved( isSaved ),
 	m_FilenameDisplay(),
 	m_WaitToPlay( false ),
@@ -19,11 +21,7 @@ MidiTrack::MidiTrack (unsigned int cellX, unsigned int cellY, const MidiTrackEve
 	m_JustFinished( false ),
 	m_LoopWaitForZero( false )
 {
-	// copy midi events from temp buffer
-	for ( unsigned int midiEventNum = 0; midiEventNum < lengthInMidiTrackEvents; midiEventNum++ )
-	{
-		m_MidiTrackEvents[midiEventNum] = midiTrackEvents[midiEventNum];
-	}
+	this->buildBlockOffsets( midiTrackEvents, allocator );
 
 	if ( filenameDisplay ) strcpy( m_FilenameDisplay, filenameDisplay );
 }
@@ -32,6 +30,40 @@ MidiTrack::~MidiTrack()
 {
 }
 
+void MidiTrack::buildBlockOffsets (const MidiTrackEvent* const midiTrackEvents, IAllocator& allocator)
+{
+	// a counting sort by block, which keeps the recorded order of events within a block, with the events past the loop end
+	// counted in an extra block at the end so that they are kept but never played
+	SharedData<unsigned int> blockCounts = SharedData<unsigned int>::MakeSharedData( m_LoopEndInBlocks + 2, &allocator );
+	for ( unsigned int block = 0; block < m_LoopEndInBlocks + 2; block++ )
+	{
+		blockCounts[block] = 0;
+	}
+	for ( unsigned int midiEventNum = 0; midiEventNum < m_LengthInMidiTrackEvents; midiEventNum++ )
+	{
+		const unsigned int timeCode = midiTrackEvents[midiEventNum].m_TimeCode;
+		blockCounts[(timeCode < m_LoopEndInBlocks) ? timeCode + 1 : m_LoopEndInBlocks + 1]++;
+	}
+
+	// the first event of each block
+	for ( unsigned int block = 1; block < m_LoopEndInBlocks + 2; block++ )
+	{
+		blockCounts[block] += blockCounts[block - 1];
+	}
+	for ( unsigned int block = 0; block <= m_LoopEndInBlocks; block++ )
+	{
+		const unsigned int offset = blockCounts[block];
+		m_BlockOffsets[block] = ( offset < MIDI_TRACK_MAX_INDEXED_EVENTS ) ? offset : MIDI_TRACK_MAX_INDEXED_EVENTS;
+	}
+
+	for ( unsigned int midiEventNum = 0; midiEventNum < m_LengthInMidiTrackEvents; midiEventNum++ )
+	{
+		const unsigned int timeCode = midiTrackEvents[midiEventNum].m_TimeCode;
+		const unsigned int block = ( timeCode < m_LoopEndInBlocks ) ? timeCode : m_LoopEndInBlocks;
+		m_MidiTrackEvents[blockCounts[block]++] = midiTrackEvents[midiEventNum];
+	}
+}
+
 bool MidiTrack::waitForLoopStartOrEnd (const unsigned int timeCode)
 {
 	if ( ! m_LoopWaitForZero && m_WaitToPlay && timeCode % m_LoopEndInBlocks == 0 )
@@ -67,29 +99,23 @@ bool MidiTrack::waitForLoopStartOrEnd (const unsigned int timeCode)
 	return false;
 }
 
-void MidiTrack::addMidiEventsAtTimeCode( const unsigned int timeCode, std::vector<MidiEvent>& midiEventOutputVector )
+unsigned int MidiTrack::addMidiEventsAtTimeCode( const unsigned int timeCode, const uint32_t blockStartSampleTime,
+							MidiEventsToSend& midiEventsToSend )
 {
-	// skip to upcoming midi track event
-	while ( m_MidiTrackEvents[m_MidiTrackEventsIndex].m_TimeCode < timeCode % m_LoopEndInBlocks
-			&& m_MidiTrackEventsIndex != m_LengthInMidiTrackEvents - 1 )
-	{
-		m_MidiTrackEventsIndex = ( m_MidiTrackEventsIndex + 1 ) % m_LengthInMidiTrackEvents;
-	}
+	MNEMONIC_PROFILE_SCOPE( ProfileScope::MIDI_TRACK_EVENTS );
 
 	// add all midi track events with the current time code to queue
-	while ( m_MidiTrackEvents[m_MidiTrackEventsIndex].m_TimeCode == timeCode % m_LoopEndInBlocks
-			&& m_LengthInMidiTrackEvents > 1 )
+	const unsigned int block = timeCode % m_LoopEndInBlocks;
+	const unsigned int lastMidiEventNum = m_BlockOffsets[block + 1];
+	unsigned int numDropped = 0;
+	for ( unsigned int midiEventNum = m_BlockOffsets[block]; midiEventNum < lastMidiEventNum; midiEventNum++ )
 	{
-		midiEventOutputVector.push_back( m_MidiTrackEvents[m_MidiTrackEventsIndex].m_MidiEvent );
-
-		m_MidiTrackEventsIndex = ( m_MidiTrackEventsIndex + 1 ) % m_LengthInMidiTrackEvents;
+		const MidiTrackEvent& midiTrackEvent = m_MidiTrackEvents[midiEventNum];
+		const uint32_t sampleTime = blockStartSampleTime + midiTrackEvent.m_SampleOffset;
+		if ( ! midiEventsToSend.push(TimedMidiEvent{midiTrackEvent.m_MidiEvent, sampleTime}) ) numDropped++;
 	}
 
-	// if we've processed the last midi track event, return to the beginning
-	if ( m_MidiTrackEventsIndex == m_LengthInMidiTrackEvents - 1 )
-	{
-		m_MidiTrackEventsIndex = 0;
-	}
+	return numDropped;
 }
 
 void MidiTrack::play (bool immediately, bool loopWaitForZero)
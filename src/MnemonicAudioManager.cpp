@@ -1,23 +1,89 @@
 #include "MnemonicAudioManager.hpp"
 
 #include "IMnemonicUiEventListener.hpp"
+#include "IStorageMedia.hpp"
+#include "B12Container.hpp"
 #include "AudioConstants.hpp"
 #include <string.h>
 #include "B12Compression.hpp"
 #include <ctype.h>
+#include "MnemonicProfiler.hpp"
+#include "MidiSampleClock.hpp"
 
-MnemonicAudioManager::MnemonicAudioManager (IStorageMedia& sdCard, uint8_t* axiSram, unsigned int axiSramSizeInBytes) :
+static const char* DirectoryNameRaw (const Directory& directory)
+{
+	switch ( directory )
+	{
+		case Directory::AUDIO:
+			return "AUDIO   ";
+		case Directory::MIDI:
+			return "MIDI    ";
+		case Directory::SCENE:
+			return "SCENE   ";
+		default:
+			return "        ";
+	}
+}
+
+// the extension of the files listed by the file explorer for a directory
+static const char* DirectoryListingExtension (const Directory& directory)
+{
+	switch ( directory )
+	{
+		case Directory::AUDIO:
+			return "B12";
+		case Directory::MIDI:
+			return "SMF";
+		case Directory::SCENE:
+			return "SCN";
+		default:
+			return nullptr;
+	}
+}
+
+static bool HasExtension (const Fat16Entry& entry, const char* extension)
+{
+	for ( unsigned int character = 0; character < FAT16_EXTENSION_SIZE; character++ )
+	{
+		if ( toupper(entry.getExtensionRaw()[character]) != extension[character] ) return false;
+	}
+
+	return true;
+}
+
+MnemonicAudioManager::MnemonicAudioManager (IStorageMedia& sdCard, uint8_t* axiSram, unsigned int axiSramSizeInBytes,
+						IAsyncStorageMedia* asyncSdCard, IReadIntoStorageMedia* readIntoSdCard) :
 	m_AxiSramAllocator( axiSram, axiSramSizeInBytes ),
 	m_FileManager( sdCard, &m_AxiSramAllocator ),
+	m_SdCard( sdCard ),
+	m_BlockingSdCard( sdCard, readIntoSdCard ),
+	m_AsyncSdCard( (asyncSdCard) ? asyncSdCard : &m_BlockingSdCard ),
+	m_Fat16Geometry(),
+	m_AudioDirectoryCluster( 0 ),
 	m_CurrentDirectory( Directory::ROOT ),
+	m_DirectoryIndices(),
 	m_TransportProgress( 0 ),
 	m_AudioTracks(),
-	m_DecompressedBuffer( m_AxiSramAllocator.allocatePrimativeArray<uint16_t>(ABUFFER_SIZE) ),
+	m_AudioTrackRingBudgetInBytes( axiSramSizeInBytes / MNEMONIC_AUDIO_RING_SRAM_DIVISOR ),
+	m_WorstSdLatencyInBlocks( 0 ),
+	m_OneshotCacheBudgetInBytes( axiSramSizeInBytes / MNEMONIC_ONESHOT_CACHE_SRAM_DIVISOR ),
+	m_StreamTelemetry(),
+	m_StreamTelemetryBlockCount( 0 ),
+	m_SampleRate( MNEMONIC_SAMPLE_RATE ),
+	m_MixBusL{ 0 },
+	m_MixBusR{ 0 },
+	m_MasterLimiter(),
 	m_MasterClockCount( 0 ),
 	m_CurrentMaxLoopCount( MNEMONIC_NEOTRELLIS_COLS ), // 8 to avoid arithmetic exception when performing modulo
+	m_LoopCalendar(),
+	m_LoopCalendarBlockCount( 0 ),
+	m_LoopingInfoChanged( false ),
 	m_ActiveMidiChannel( 1 ),
 	m_MidiTracks(),
 	m_MidiEventsToSend(),
+	m_NumMidiEventsDropped( 0 ),
+	m_MidiSampleClock( nullptr ),
+	m_BlockStartSampleTime( 0 ),
 	m_RecordingMidiState( MidiRecordingState::NOT_RECORDING ),
 	m_TempMidiTrackEvents( reinterpret_cast<MidiTrackEvent*>(
 				m_AxiSramAllocator.allocatePrimativeArray<uint8_t>(MNEMONIC_MAX_MIDI_TRACK_EVENTS * sizeof(MidiTrackEvent))) ),
@@ -31,6 +97,11 @@ MnemonicAudioManager::MnemonicAudioManager (IStorageMedia& sdCard, uint8_t* axiS
 
 MnemonicAudioManager::~MnemonicAudioManager()
 {
+	// make sure no read is still writing into a track's buffer
+	for ( AudioTrack& audioTrack : m_AudioTracks )
+	{
+		audioTrack.reset();
+	}
 }
 
 void MnemonicAudioManager::publishUiEvents()
@@ -68,6 +139,36 @@ void MnemonicAudioManager::publishUiEvents()
 			this->resetLoopingInfo();
 		}
 	}
+
+	if ( m_StreamTelemetryBlockCount >= MNEMONIC_STREAM_TELEMETRY_PERIOD_IN_BLOCKS )
+	{
+		this->publishStreamTelemetry();
+		m_StreamTelemetryBlockCount = 0;
+	}
+}
+
+void MnemonicAudioManager::publishStreamTelemetry()
+{
+	m_StreamTelemetry.m_NumUnderruns = 0;
+	m_StreamTelemetry.m_NumTracks = 0;
+	for ( const AudioTrack& audioTrack : m_AudioTracks )
+	{
+		if ( m_StreamTelemetry.m_NumTracks == MNEMONIC_NEOTRELLIS_ROWS * MNEMONIC_NEOTRELLIS_COLS ) break;
+
+		UiStreamTrackTelemetry& trackTelemetry = m_StreamTelemetry.m_Tracks[m_StreamTelemetry.m_NumTracks];
+		trackTelemetry.m_CellX = audioTrack.getCellX();
+		trackTelemetry.m_CellY = audioTrack.getCellY();
+		trackTelemetry.m_NumUnderruns = audioTrack.getNumUnderruns();
+		trackTelemetry.m_MinBlocksBuffered = audioTrack.getMinBlocksBuffered();
+		trackTelemetry.m_RingDepth = audioTrack.getRingDepth();
+		trackTelemetry.m_IsResident = audioTrack.isResident();
+
+		m_StreamTelemetry.m_NumUnderruns += trackTelemetry.m_NumUnderruns;
+		m_StreamTelemetry.m_NumTracks++;
+	}
+
+	IMnemonicUiEventListener::PublishEvent( MnemonicUiEvent(UiEventType::STREAM_TELEMETRY, &m_StreamTelemetry,
+								m_StreamTelemetry.m_NumTracks, 0) );
 }
 
 void MnemonicAudioManager::verifyFileSystem()
@@ -76,11 +177,44 @@ void MnemonicAudioManager::verifyFileSystem()
 	{
 		IMnemonicUiEventListener::PublishEvent( MnemonicUiEvent(UiEventType::INVALID_FILESYSTEM, nullptr, 0, 0) );
 		this->unbindFromMnemonicParameterEventSystem();
+
+		return;
+	}
+
+	// cache the volume layout and audio directory location for streaming audio tracks
+	m_Fat16Geometry = Fat16SectorStream::GetGeometry( m_SdCard, m_FileManager );
+	m_AudioDirectoryCluster = Fat16SectorStream::FindStartingCluster( m_SdCard, m_Fat16Geometry, 0, DirectoryNameRaw(Directory::AUDIO),
+										"   " );
+
+	// index the root directory and each of the mnemonic directories that exist, so files are found by name without a scan
+	this->goToDirectory( Directory::ROOT );
+	Fat16DirectoryIndex& rootIndex = this->getDirectoryIndex( Directory::ROOT );
+	rootIndex.build( m_FileManager.getCurrentDirectoryEntries(), &m_AxiSramAllocator );
+	for ( const Directory directory : { Directory::AUDIO, Directory::MIDI, Directory::SCENE } )
+	{
+		unsigned int entryNum = 0;
+		if ( rootIndex.findRaw(DirectoryNameRaw(directory), "   ", entryNum) && this->goToDirectory(directory) )
+		{
+			this->getDirectoryIndex( directory ).build( m_FileManager.getCurrentDirectoryEntries(), &m_AxiSramAllocator );
+			this->buildFileExplorerListing( directory );
+		}
 	}
 }
 
 void MnemonicAudioManager::call (int16_t* writeBufferL, int16_t* writeBufferR)
 {
+	MNEMONIC_PROFILE_BLOCK( ProfileScope::AUDIO_MANAGER_CALL );
+
+	// the dac is partway through the block before this one, so this block starts playing at the next block boundary
+	if ( m_MidiSampleClock )
+	{
+		m_BlockStartSampleTime = ( (m_MidiSampleClock->getSampleCount() / ABUFFER_SIZE) + 1 ) * ABUFFER_SIZE;
+	}
+	else
+	{
+		m_BlockStartSampleTime += ABUFFER_SIZE;
+	}
+
 	// update transport state
 	const unsigned int numSamplesPerCell = m_CurrentMaxLoopCount / MNEMONIC_NEOTRELLIS_COLS;
 	const unsigned int progressInCell = m_MasterClockCount % ( numSamplesPerCell );
@@ -103,6 +237,7 @@ void MnemonicAudioManager::call (int16_t* writeBufferL, int16_t* writeBufferR)
 			if ( m_TempMidiTrackCellY == midiTrack.getCellY() )
 			{
 				midiTrack.stop( true );
+				m_LoopingInfoChanged = true;
 			}
 		}
 	}
@@ -113,32 +248,217 @@ void MnemonicAudioManager::call (int16_t* writeBufferL, int16_t* writeBufferR)
 
 	// update master clock count state
 	m_MasterClockCount = ( m_MasterClockCount + 1 ) % m_CurrentMaxLoopCount;
+	m_LoopCalendarBlockCount++;
+
+	// read ahead for all playing audio tracks before any decoding happens
+	this->streamAudioTracks();
+	m_StreamTelemetryBlockCount++;
+
+	// mix audio track data on the 32-bit buses, so overlapping tracks can't wrap around before the limiter
+	for ( unsigned int sample = 0; sample < ABUFFER_SIZE; sample++ )
+	{
+		m_MixBusL[sample] = 0;
+		m_MixBusR[sample] = 0;
+	}
 
-	// fill buffer with audio track data
 	for ( AudioTrack& audioTrack : m_AudioTracks )
 	{
-		audioTrack.call( writeBufferL, writeBufferR );
+		// resident tracks finish on their last block rather than on their last read
+		const bool wasPlaying = audioTrack.isPlaying();
+		audioTrack.call( m_MixBusL, m_MixBusR );
+		if ( wasPlaying && ! audioTrack.isPlaying() ) m_LoopingInfoChanged = true;
+	}
 
-		if ( audioTrack.shouldLoop(m_MasterClockCount) )
-		{
-			audioTrack.play();
-		}
+	// start, stop or restart the loops of the tracks with a boundary on this block
+	LoopBoundary loopBoundary;
+	while ( m_LoopCalendar.popDue(m_LoopCalendarBlockCount, loopBoundary) )
+	{
+		this->handleLoopBoundary( loopBoundary );
 	}
 
 	// fill midi event queue with midi events at this time code
 	for ( MidiTrack& midiTrack : m_MidiTracks )
 	{
-		midiTrack.waitForLoopStartOrEnd( m_MasterClockCount );
-
 		if ( midiTrack.isPlaying() )
 		{
-			midiTrack.addMidiEventsAtTimeCode( m_MasterClockCount, m_MidiEventsToSend );
+			m_NumMidiEventsDropped += midiTrack.addMidiEventsAtTimeCode( m_MasterClockCount, m_BlockStartSampleTime,
+											m_MidiEventsToSend );
 		}
 	}
 
-	this->resetLoopingInfo();
+	if ( m_LoopingInfoChanged )
+	{
+		m_LoopingInfoChanged = false;
+		this->resetLoopingInfo();
+	}
 
-	// TODO add limiter stage
+	// limit the mix and convert to the dac range once, at the very end
+	m_MasterLimiter.process( m_MixBusL, m_MixBusR, writeBufferL, writeBufferR );
+}
+
+void MnemonicAudioManager::streamAudioTracks()
+{
+	// land any reads that completed since the last block, the last read of a file stops the track
+	for ( AudioTrack& audioTrack : m_AudioTracks )
+	{
+		if ( audioTrack.pollPendingRead() )
+		{
+			this->recordReadLatency( audioTrack.getLastReadLatencyInBlocks() );
+			if ( ! audioTrack.isPlaying() ) m_LoopingInfoChanged = true;
+		}
+	}
+
+	// each pass submits a read for whichever track will starve soonest with as many contiguous sectors as it can take, so
+	// when the sd card can't keep up it's the tracks with the most slack that miss a block, and the number of sectors read per
+	// block is capped so the audio path can't stall on storage
+	unsigned int sectorsRead = 0;
+	while ( sectorsRead < MNEMONIC_MAX_SECTOR_READS_PER_BLOCK )
+	{
+		AudioTrack* mostUrgentTrack = nullptr;
+		unsigned int fewestBlocksUntilUnderrun = std::numeric_limits<unsigned int>::max();
+		for ( AudioTrack& audioTrack : m_AudioTracks )
+		{
+			if ( audioTrack.needsNextSector() )
+			{
+				const unsigned int blocksUntilUnderrun = audioTrack.getBlocksUntilUnderrun();
+				if ( blocksUntilUnderrun < fewestBlocksUntilUnderrun )
+				{
+					mostUrgentTrack = &audioTrack;
+					fewestBlocksUntilUnderrun = blocksUntilUnderrun;
+				}
+			}
+		}
+
+		if ( ! mostUrgentTrack ) break;
+
+		const unsigned int numSectorsRead = mostUrgentTrack->submitNextSectors( MNEMONIC_MAX_SECTOR_READS_PER_BLOCK - sectorsRead );
+		if ( numSectorsRead == 0 ) break;
+
+		// a blocking backend has already finished the read, in which case the track may be picked again
+		if ( mostUrgentTrack->pollPendingRead() )
+		{
+			this->recordReadLatency( mostUrgentTrack->getLastReadLatencyInBlocks() );
+			if ( ! mostUrgentTrack->isPlaying() ) m_LoopingInfoChanged = true;
+		}
+
+		sectorsRead += numSectorsRead;
+	}
+}
+
+void MnemonicAudioManager::recordReadLatency (unsigned int readLatencyInBlocks)
+{
+	if ( readLatencyInBlocks > m_WorstSdLatencyInBlocks ) m_WorstSdLatencyInBlocks = readLatencyInBlocks;
+
+	// power of two buckets, so a handful of counters covers everything from a fast card to a stalled one
+	unsigned int bucket = 0;
+	while ( readLatencyInBlocks > 0 && bucket < MNEMONIC_SD_LATENCY_HISTOGRAM_BUCKETS - 1 )
+	{
+		readLatencyInBlocks >>= 1;
+		bucket++;
+	}
+
+	m_StreamTelemetry.m_ReadLatencyHistogram[bucket]++;
+	m_StreamTelemetry.m_NumReads++;
+	m_StreamTelemetry.m_WorstReadLatencyInBlocks = m_WorstSdLatencyInBlocks;
+}
+
+// the whole ring units of the size wanted that fit in a track's share of the ring budget, at least 1
+static unsigned int RingUnitsInShare (const AudioTrack& audioTrack, unsigned int sizeWantedInBytes, unsigned int shareInBytes)
+{
+	const unsigned int sizeInBytes = ( sizeWantedInBytes < shareInBytes ) ? sizeWantedInBytes : shareInBytes;
+	const unsigned int numRingUnits = sizeInBytes / audioTrack.getRingUnitSizeInBytes();
+
+	return ( numRingUnits > 0 ) ? numRingUnits : 1;
+}
+
+unsigned int MnemonicAudioManager::getAudioTrackRingSizeWanted (const AudioTrack& audioTrack) const
+{
+	// enough ring to cover the slowest read seen so far plus the block being decoded, which may exceed the usual cap, worked
+	// out from the track's own consumption since mono, stereo and resampled tracks go through a ring unit at different rates
+	const unsigned int latencyRingUnits = audioTrack.getRingUnitsToCover( m_WorstSdLatencyInBlocks + 1 );
+	const unsigned int numRingUnits = ( latencyRingUnits > MNEMONIC_MAX_AUDIO_RING_UNITS ) ? latencyRingUnits
+										: MNEMONIC_MAX_AUDIO_RING_UNITS;
+
+	return numRingUnits * audioTrack.getRingUnitSizeInBytes();
+}
+
+void MnemonicAudioManager::resizeAudioTrackRings()
+{
+	// resident tracks don't have a ring to share
+	unsigned int numStreamingTracks = 0;
+	for ( const AudioTrack& audioTrack : m_AudioTracks )
+	{
+		if ( ! audioTrack.isResident() ) numStreamingTracks++;
+	}
+	if ( numStreamingTracks == 0 ) return;
+
+	// loop heads come out of the same budget
+	unsigned int loopHeadsSizeInBytes = 0;
+	for ( const AudioTrack& audioTrack : m_AudioTracks )
+	{
+		loopHeadsSizeInBytes += audioTrack.getLoopHeadSizeInBytes();
+	}
+	const unsigned int ringBudgetInBytes = ( m_AudioTrackRingBudgetInBytes > loopHeadsSizeInBytes )
+						? m_AudioTrackRingBudgetInBytes - loopHeadsSizeInBytes : 0;
+
+	// split the budget in bytes, where the tracks that want less than an even share give what they don't use to the rest, so
+	// each pass can only raise the share and it settles within a pass per track
+	unsigned int shareInBytes = ringBudgetInBytes / numStreamingTracks;
+	for ( unsigned int pass = 0; pass < numStreamingTracks; pass++ )
+	{
+		unsigned int settledSizeInBytes = 0;
+		unsigned int numSettledTracks = 0;
+		for ( const AudioTrack& audioTrack : m_AudioTracks )
+		{
+			if ( audioTrack.isResident() ) continue;
+
+			const unsigned int sizeWanted = this->getAudioTrackRingSizeWanted( audioTrack );
+			if ( sizeWanted <= shareInBytes )
+			{
+				settledSizeInBytes += sizeWanted;
+				numSettledTracks++;
+			}
+		}
+		if ( numSettledTracks == numStreamingTracks || settledSizeInBytes > ringBudgetInBytes ) break;
+
+		const unsigned int newShareInBytes = ( ringBudgetInBytes - settledSizeInBytes ) / ( numStreamingTracks - numSettledTracks );
+		if ( newShareInBytes <= shareInBytes ) break;
+		shareInBytes = newShareInBytes;
+	}
+
+	// shrink first so that the freed memory is available to the tracks that grow
+	for ( AudioTrack& audioTrack : m_AudioTracks )
+	{
+		const unsigned int numRingUnits = RingUnitsInShare( audioTrack, this->getAudioTrackRingSizeWanted(audioTrack), shareInBytes );
+		if ( ! audioTrack.isResident() && audioTrack.getRingDepth() > numRingUnits ) audioTrack.setRingDepth( numRingUnits );
+	}
+
+	for ( AudioTrack& audioTrack : m_AudioTracks )
+	{
+		const unsigned int numRingUnits = RingUnitsInShare( audioTrack, this->getAudioTrackRingSizeWanted(audioTrack), shareInBytes );
+		if ( ! audioTrack.isResident() && audioTrack.getRingDepth() < numRingUnits ) audioTrack.setRingDepth( numRingUnits );
+	}
+}
+
+void MnemonicAudioManager::cacheOneshotTracks (unsigned int firstTrackIndex, unsigned int numTracks)
+{
+	unsigned int cacheUsedInBytes = 0;
+	for ( const AudioTrack& audioTrack : m_AudioTracks )
+	{
+		if ( audioTrack.isResident() ) cacheUsedInBytes += audioTrack.getResidentSizeInBytes();
+	}
+
+	for ( unsigned int track = firstTrackIndex; track < firstTrackIndex + numTracks; track++ )
+	{
+		cacheUsedInBytes += m_AudioTracks[track].getResidentSizeInBytes();
+	}
+
+	if ( cacheUsedInBytes > m_OneshotCacheBudgetInBytes ) return;
+
+	for ( unsigned int track = firstTrackIndex; track < firstTrackIndex + numTracks; track++ )
+	{
+		m_AudioTracks[track].makeResident();
+	}
 }
 
 void MnemonicAudioManager::onMidiEvent (const MidiEvent& midiEvent)
@@ -148,20 +468,35 @@ void MnemonicAudioManager::onMidiEvent (const MidiEvent& midiEvent)
 	MidiEvent midiEventWithChannel = midiEvent;
 	midiEventWithChannel.setChannel( midiChannel );
 
+	// the time the message arrived, or if it has no timestamp the time it was dispatched, without a clock it's the block's start
+	uint32_t arrivalSampleTime = m_BlockStartSampleTime - ABUFFER_SIZE;
+	if ( m_MidiSampleClock && ! m_MidiSampleClock->popTimestamp(midiEvent.getRawData()[0], arrivalSampleTime) )
+	{
+		arrivalSampleTime = m_MidiSampleClock->getSampleCount();
+	}
+
 	// TODO probably need to keep track of what midi messages have a note on without a note off, to apply those at the end of the loop
 	if ( m_RecordingMidiState == MidiRecordingState::RECORDING && m_TempMidiTrackEventsIndex < MNEMONIC_MAX_MIDI_TRACK_EVENTS )
 	{
 		m_TempMidiTrackEvents[m_TempMidiTrackEventsIndex].m_MidiEvent = midiEventWithChannel;
 		m_TempMidiTrackEvents[m_TempMidiTrackEventsIndex].m_TimeCode = m_MasterClockCount;
+		m_TempMidiTrackEvents[m_TempMidiTrackEventsIndex].m_SampleOffset = this->getSampleOffsetInBlock( arrivalSampleTime );
 
 		m_TempMidiTrackEventsIndex++;
-
-		m_MidiEventsToSend.push_back( midiEventWithChannel );
-	}
-	else
-	{
-		m_MidiEventsToSend.push_back( midiEventWithChannel );
 	}
+
+	// passed through as soon as possible, since the arrival time has already gone by
+	if ( ! m_MidiEventsToSend.push(TimedMidiEvent{midiEventWithChannel, arrivalSampleTime}) ) m_NumMidiEventsDropped++;
+}
+
+unsigned int MnemonicAudioManager::getSampleOffsetInBlock (uint32_t sampleTime) const
+{
+	// events are recorded against the block from the last call, which was computed as the dac started on the block before it,
+	// so that's the block the offset is from, and events that fall outside it are clamped to its ends
+	const int32_t sampleOffset = static_cast<int32_t>( sampleTime - (m_BlockStartSampleTime - ABUFFER_SIZE) );
+	if ( sampleOffset < 0 ) return 0;
+
+	return ( sampleOffset < static_cast<int32_t>(ABUFFER_SIZE) ) ? static_cast<unsigned int>( sampleOffset ) : ABUFFER_SIZE - 1;
 }
 
 void MnemonicAudioManager::startRecordingMidiTrack (unsigned int cellX, unsigned int cellY)
@@ -201,6 +536,7 @@ void MnemonicAudioManager::endRecordingMidiTrack (unsigned int cellX, unsigned i
 			m_MidiTracks.push_back( midiTrack );
 
 			m_MidiTracks.back().play( true );
+			m_LoopingInfoChanged = true;
 
 			m_RecordingMidiState = MidiRecordingState::JUST_FINISHED_RECORDING;
 		}
@@ -223,22 +559,12 @@ void MnemonicAudioManager::saveMidiRecording (unsigned int cellX, unsigned int c
 
 			// check for a duplicate and delete if necessary
 			unsigned int entryNum = 0;
-			std::vector<Fat16Entry*>& dirEntries = m_FileManager.getCurrentDirectoryEntries();
-			for ( const Fat16Entry* const entryPtr : dirEntries )
+			if ( this->getDirectoryIndex(Directory::MIDI).findRaw(entry.getFilenameRaw(), entry.getExtensionRaw(), entryNum) )
 			{
-				const char* entryPtrFilename = entryPtr->getFilenameDisplay();
-				const char* newEntryFilename = entry.getFilenameDisplay();
-				if ( strcmp(entryPtrFilename, newEntryFilename) == 0 )
-				{
-					m_FileManager.deleteEntry( entryNum );
-
-					break;
-				}
-
-				entryNum++;
+				this->deleteEntry( entryNum );
 			}
 
-			if ( m_FileManager.createEntry(entry) )
+			if ( this->createEntry(entry) )
 			{
 				// get data necessary to reconstruct midi track
 				SharedData<MidiTrackEvent> midiData = midiTrack.getData();
@@ -354,22 +680,12 @@ void MnemonicAudioManager::saveScene (const char* nameWithoutExt)
 
 	// check for a duplicate and delete if necessary
 	unsigned int entryNum = 0;
-	std::vector<Fat16Entry*>& dirEntries = m_FileManager.getCurrentDirectoryEntries();
-	for ( const Fat16Entry* const entryPtr : dirEntries )
+	if ( this->getDirectoryIndex(Directory::SCENE).findRaw(entry.getFilenameRaw(), entry.getExtensionRaw(), entryNum) )
 	{
-		const char* entryPtrFilename = entryPtr->getFilenameDisplay();
-		const char* newEntryFilename = entry.getFilenameDisplay();
-		if ( strcmp(entryPtrFilename, newEntryFilename) == 0 )
-		{
-			m_FileManager.deleteEntry( entryNum );
-
-			break;
-		}
-
-		entryNum++;
+		this->deleteEntry( entryNum );
 	}
 
-	if ( m_FileManager.createEntry(entry) )
+	if ( this->createEntry(entry) )
 	{
 		if ( ! m_FileManager.flushToEntry(entry, data) ) goto fail;
 
@@ -470,94 +786,97 @@ void MnemonicAudioManager::onMnemonicParameterEvent (const MnemonicParameterEven
 	}
 }
 
-uint8_t* MnemonicAudioManager::enterFileExplorerHelper (const char* extension, unsigned int& numEntries, uint8_t* previousPtr)
+void MnemonicAudioManager::enterFileExplorer (const Directory& dir)
 {
-	// look for extensions both upper and lower case
-	char extensionLowerCase[FAT16_EXTENSION_SIZE + 1];
-	char extensionUpperCase[FAT16_EXTENSION_SIZE + 1];
-	strcpy( extensionLowerCase, extension );
-	strcpy( extensionUpperCase, extension );
-	for ( unsigned int charNum = 0; charNum < FAT16_EXTENSION_SIZE + 1; charNum++ )
+	// the listings are kept up to date as files are created and deleted, so there's nothing to build here, but loading and
+	// deleting by index happen in the current directory
+	if ( ! this->goToDirectory(dir) ) return;
+
+	FileExplorerListing& listing = m_FileExplorerListings[static_cast<unsigned int>(dir)];
+	uint8_t* listingPtr = reinterpret_cast<uint8_t*>( listing.m_Entries );
+
+	// send the ui event with all this data
+	if ( dir == Directory::AUDIO )
 	{
-		extensionLowerCase[charNum] = tolower( extensionLowerCase[charNum] );
-		extensionUpperCase[charNum] = toupper( extensionUpperCase[charNum] );
+		IMnemonicUiEventListener::PublishEvent( MnemonicUiEvent(UiEventType::ENTER_FILE_EXPLORER, listingPtr, listing.m_NumEntries, 0) );
 	}
-
-	// get all b12 file entries and place them in vector
-	std::vector<UiFileExplorerEntry> uiEntryVec;
-	unsigned int index = 0;
-	for ( const Fat16Entry* entry : m_FileManager.getCurrentDirectoryEntries() )
+	else if ( dir == Directory::MIDI ) // filter midi files instead
 	{
-		if ( ! entry->isDeletedEntry() && (strncmp(entry->getExtensionRaw(), extensionLowerCase, FAT16_EXTENSION_SIZE) == 0
-			|| strncmp(entry->getExtensionRaw(), extensionUpperCase, FAT16_EXTENSION_SIZE) == 0) )
-		{
-			UiFileExplorerEntry uiEntry;
-			strcpy( uiEntry.m_FilenameDisplay, entry->getFilenameDisplay() );
-			uiEntry.m_Index = index;
-
-			uiEntryVec.push_back( uiEntry );
-		}
-
-		index++;
+		IMnemonicUiEventListener::PublishEvent( MnemonicUiEvent(UiEventType::ENTER_FILE_EXPLORER, listingPtr, listing.m_NumEntries, 1) );
+	}
+	else if ( dir == Directory::SCENE ) // filter scene files instead
+	{
+		IMnemonicUiEventListener::PublishEvent( MnemonicUiEvent(UiEventType::ENTER_FILE_EXPLORER, listingPtr, listing.m_NumEntries, 2) );
 	}
+}
 
-	// free the previous data if necessary
-	if ( previousPtr ) m_AxiSramAllocator.free( previousPtr );
+void MnemonicAudioManager::buildFileExplorerListing (const Directory& dir)
+{
+	const char* extension = DirectoryListingExtension( dir );
+	if ( ! extension ) return;
 
-	// allocate them in contiguous memory for ui use
-	uint8_t* primArrayPtr = m_AxiSramAllocator.allocatePrimativeArray<uint8_t>( sizeof(UiFileExplorerEntry) * uiEntryVec.size() );
+	FileExplorerListing& listing = m_FileExplorerListings[static_cast<unsigned int>(dir)];
+	if ( listing.m_Entries ) m_AxiSramAllocator.free( reinterpret_cast<uint8_t*>(listing.m_Entries) );
+	listing.m_Entries = nullptr;
+	listing.m_NumEntries = 0;
+	listing.m_Capacity = 0;
 
-	UiFileExplorerEntry* entryArrayPtr = reinterpret_cast<UiFileExplorerEntry*>( primArrayPtr );
-	index = 0;
-	for ( const UiFileExplorerEntry& entry : uiEntryVec )
+	unsigned int index = 0;
+	for ( const Fat16Entry* entry : m_FileManager.getCurrentDirectoryEntries() )
 	{
-		entryArrayPtr[index] = entry;
+		this->addToFileExplorerListing( dir, *entry, index );
 		index++;
 	}
-
-	numEntries = uiEntryVec.size();
-
-	return primArrayPtr;
 }
 
-void MnemonicAudioManager::enterFileExplorer (const Directory& dir)
+void MnemonicAudioManager::addToFileExplorerListing (const Directory& dir, const Fat16Entry& entry, unsigned int index)
 {
-	static uint8_t* b12PrimArrayPtr = nullptr;
-	static unsigned int b12NumEntries = 0;
-	static uint8_t* midPrimArrayPtr = nullptr;
-	static unsigned int midNumEntries = 0;
-	static uint8_t* scnPrimArrayPtr = nullptr;
-	static unsigned int scnNumEntries = 0;
+	const char* extension = DirectoryListingExtension( dir );
+	if ( ! extension || entry.isDeletedEntry() || ! HasExtension(entry, extension) ) return;
 
-	// since the sd card is not hot-pluggable, we only need to get the list of audio entries once
-	if ( dir == Directory::AUDIO && b12PrimArrayPtr == nullptr )
-	{
-		this->goToDirectory( Directory::AUDIO );
-		b12PrimArrayPtr = this->enterFileExplorerHelper( "B12", b12NumEntries, b12PrimArrayPtr );
-	}
-	else if ( dir == Directory::MIDI )
-	{
-		this->goToDirectory( Directory::MIDI );
-		midPrimArrayPtr = this->enterFileExplorerHelper( "SMF", midNumEntries, midPrimArrayPtr );
-	}
-	else if ( dir == Directory::SCENE )
+	FileExplorerListing& listing = m_FileExplorerListings[static_cast<unsigned int>(dir)];
+	if ( listing.m_NumEntries == listing.m_Capacity )
 	{
-		this->goToDirectory( Directory::SCENE );
-		scnPrimArrayPtr = this->enterFileExplorerHelper( "SCN", scnNumEntries, scnPrimArrayPtr );
-	}
+		// only grows by reallocating when the spare entries run out
+		const unsigned int newCapacity = ( listing.m_Capacity * 2 ) + MNEMONIC_FILE_EXPLORER_SPARE_ENTRIES;
+		UiFileExplorerEntry* newEntries = reinterpret_cast<UiFileExplorerEntry*>(
+					m_AxiSramAllocator.allocatePrimativeArray<uint8_t>(sizeof(UiFileExplorerEntry) * newCapacity) );
+		if ( listing.m_Entries )
+		{
+			memcpy( newEntries, listing.m_Entries, sizeof(UiFileExplorerEntry) * listing.m_NumEntries );
+			m_AxiSramAllocator.free( reinterpret_cast<uint8_t*>(listing.m_Entries) );
+		}
 
-	// send the ui event with all this data
-	if ( dir == Directory::AUDIO )
-	{
-		IMnemonicUiEventListener::PublishEvent( MnemonicUiEvent(UiEventType::ENTER_FILE_EXPLORER, b12PrimArrayPtr, b12NumEntries, 0) );
+		listing.m_Entries = newEntries;
+		listing.m_Capacity = newCapacity;
 	}
-	else if ( dir == Directory::MIDI ) // filter midi files instead
+
+	// keep directory order, a new entry may have taken the place of a deleted one
+	unsigned int position = listing.m_NumEntries;
+	while ( position > 0 && listing.m_Entries[position - 1].m_Index > index )
 	{
-		IMnemonicUiEventListener::PublishEvent( MnemonicUiEvent(UiEventType::ENTER_FILE_EXPLORER, midPrimArrayPtr, midNumEntries, 1) );
+		listing.m_Entries[position] = listing.m_Entries[position - 1];
+		position--;
 	}
-	else if ( dir == Directory::SCENE ) // filter scene files instead
+
+	strcpy( listing.m_Entries[position].m_FilenameDisplay, entry.getFilenameDisplay() );
+	listing.m_Entries[position].m_Index = index;
+	listing.m_NumEntries++;
+}
+
+void MnemonicAudioManager::removeFromFileExplorerListing (const Directory& dir, unsigned int index)
+{
+	FileExplorerListing& listing = m_FileExplorerListings[static_cast<unsigned int>(dir)];
+	for ( unsigned int position = 0; position < listing.m_NumEntries; position++ )
 	{
-		IMnemonicUiEventListener::PublishEvent( MnemonicUiEvent(UiEventType::ENTER_FILE_EXPLORER, scnPrimArrayPtr, scnNumEntries, 2) );
+		if ( listing.m_Entries[position].m_Index == index )
+		{
+			memmove( &listing.m_Entries[position], &listing.m_Entries[position + 1],
+					sizeof(UiFileExplorerEntry) * (listing.m_NumEntries - position - 1) );
+			listing.m_NumEntries--;
+
+			return;
+		}
 	}
 }
 
@@ -659,6 +978,10 @@ void MnemonicAudioManager::playOrStopTrack (unsigned int cellX, unsigned int cel
 			}
 		}
 	}
+
+	// the max loop count follows at the end of the next block, as it would for a track starting on its own
+	this->rebuildLoopCalendar();
+	m_LoopingInfoChanged = true;
 }
 
 void MnemonicAudioManager::loadFile (unsigned int cellX, unsigned int cellY, unsigned int index)
@@ -735,6 +1058,8 @@ void MnemonicAudioManager::unloadFile (unsigned int cellX, unsigned int cellY)
 				// look for stereo entry before erasing track
 				entryOtherChannel = this->lookForOtherChannel( trackInVec.getFatEntry().getFilenameDisplay() );
 
+				// make sure no read is still writing into the track's buffer
+				trackInVec.reset();
 				m_AudioTracks.erase( trackInVecIt );
 
 				break;
@@ -749,12 +1074,15 @@ void MnemonicAudioManager::unloadFile (unsigned int cellX, unsigned int cellY)
 				AudioTrack& trackInVec = *trackInVecIt;
 				if ( cellX == trackInVec.getCellX() && cellY == trackInVec.getCellY() )
 				{
+					trackInVec.reset();
 					m_AudioTracks.erase( trackInVecIt );
 
 					break;
 				}
 			}
 		}
+
+		this->resizeAudioTrackRings();
 	}
 	else if ( row == MNEMONIC_ROW::MIDI_CHAN_1_LOOPS || row == MNEMONIC_ROW::MIDI_CHAN_2_LOOPS
 			|| row == MNEMONIC_ROW::MIDI_CHAN_3_LOOPS || row == MNEMONIC_ROW::MIDI_CHAN_4_LOOPS )
@@ -771,15 +1099,21 @@ void MnemonicAudioManager::unloadFile (unsigned int cellX, unsigned int cellY)
 			}
 		}
 	}
+
+	// erasing moves the tracks after the unloaded one, so the calendar's indices are stale
+	this->rebuildLoopCalendar();
+	m_LoopingInfoChanged = true;
 }
 
 void MnemonicAudioManager::deleteFile (unsigned int index)
 {
-	m_FileManager.deleteEntry( index );
+	this->deleteEntry( index );
 }
 
 void MnemonicAudioManager::resetLoopingInfo()
 {
+	MNEMONIC_PROFILE_SCOPE( ProfileScope::RESET_LOOPING_INFO );
+
 	// reset looping info if necessary
 	unsigned int maxLoopCount = MNEMONIC_NEOTRELLIS_COLS; // 8 to avoid arithmetic exception when performing modulo
 	for ( MidiTrack& midiTrack : m_MidiTracks )
@@ -800,13 +1134,75 @@ void MnemonicAudioManager::resetLoopingInfo()
 		}
 	}
 
-	if ( maxLoopCount < m_CurrentMaxLoopCount )
+	if ( maxLoopCount != m_CurrentMaxLoopCount )
 	{
 		m_CurrentMaxLoopCount = maxLoopCount;
+
+		// every boundary past the master clock wrapping has moved
+		this->rebuildLoopCalendar();
 	}
-	else if ( maxLoopCount > m_CurrentMaxLoopCount )
+}
+
+// the blocks from clockCount to the next multiple of loopLength, where the master clock wrapping back to 0 always is one
+static unsigned int BlocksUntilLoopBoundary (unsigned int clockCount, unsigned int loopLength, unsigned int maxLoopCount)
+{
+	loopLength = ( loopLength > 0 ) ? loopLength : 1;
+
+	// the clock may be past a max loop count that just shrank, in which case it wraps partway on its next block
+	const unsigned int nextClockCount = ( clockCount + 1 ) % maxLoopCount;
+	if ( nextClockCount % loopLength == 0 ) return 1;
+
+	const unsigned int nextBoundary = ( (nextClockCount / loopLength) + 1 ) * loopLength;
+
+	return 1 + ( (nextBoundary < maxLoopCount) ? nextBoundary : maxLoopCount ) - nextClockCount;
+}
+
+void MnemonicAudioManager::rebuildLoopCalendar()
+{
+	m_LoopCalendar.clear();
+
+	for ( unsigned int track = 0; track < m_AudioTracks.size(); track++ )
 	{
-		m_CurrentMaxLoopCount = maxLoopCount;
+		if ( m_AudioTracks[track].needsLoopBoundaries() ) this->scheduleLoopBoundary( LoopTrackType::AUDIO, track );
+	}
+
+	for ( unsigned int track = 0; track < m_MidiTracks.size(); track++ )
+	{
+		if ( m_MidiTracks[track].needsLoopBoundaries() ) this->scheduleLoopBoundary( LoopTrackType::MIDI, track );
+	}
+}
+
+void MnemonicAudioManager::scheduleLoopBoundary (const LoopTrackType trackType, const unsigned int trackIndex)
+{
+	const unsigned int loopLength = ( trackType == LoopTrackType::AUDIO ) ? m_AudioTracks[trackIndex].getLoopLengthInAudioBlocks()
+										: m_MidiTracks[trackIndex].getLoopEndInBlocks();
+	const unsigned int blocksUntilBoundary = BlocksUntilLoopBoundary( m_MasterClockCount, loopLength, m_CurrentMaxLoopCount );
+
+	// the calendar has room for every cell, so this only fails if more tracks are loaded than there are cells
+	m_LoopCalendar.schedule( m_LoopCalendarBlockCount + blocksUntilBoundary, trackType, trackIndex );
+}
+
+void MnemonicAudioManager::handleLoopBoundary (const LoopBoundary& boundary)
+{
+	if ( boundary.m_TrackType == LoopTrackType::AUDIO )
+	{
+		AudioTrack& audioTrack = m_AudioTracks[boundary.m_TrackIndex];
+		if ( audioTrack.shouldLoop(m_MasterClockCount) )
+		{
+			audioTrack.play();
+			m_LoopingInfoChanged = true;
+		}
+
+		if ( audioTrack.needsLoopBoundaries() ) this->scheduleLoopBoundary( LoopTrackType::AUDIO, boundary.m_TrackIndex );
+	}
+	else
+	{
+		MidiTrack& midiTrack = m_MidiTracks[boundary.m_TrackIndex];
+		const bool wasPlaying = midiTrack.isPlaying();
+		midiTrack.waitForLoopStartOrEnd( m_MasterClockCount );
+		if ( midiTrack.isPlaying() != wasPlaying ) m_LoopingInfoChanged = true;
+
+		if ( midiTrack.needsLoopBoundaries() ) this->scheduleLoopBoundary( LoopTrackType::MIDI, boundary.m_TrackIndex );
 	}
 }
 
@@ -839,12 +1235,10 @@ Fat16Entry* MnemonicAudioManager::lookForOtherChannel (const char* filenameDispl
 		return nullptr;
 	}
 
-	for ( Fat16Entry* entry : m_FileManager.getCurrentDirectoryEntries() )
+	unsigned int entryNum = 0;
+	if ( this->getDirectoryIndex(m_CurrentDirectory).find(filenameToLookFor, entryNum) )
 	{
-		if ( strcmp(entry->getFilenameDisplay(), filenameToLookFor) == 0 )
-		{
-			return entry;
-		}
+		return m_FileManager.getCurrentDirectoryEntries()[entryNum];
 	}
 
 	return nullptr;
@@ -852,43 +1246,24 @@ Fat16Entry* MnemonicAudioManager::lookForOtherChannel (const char* filenameDispl
 
 bool MnemonicAudioManager::goToDirectory (const Directory& directory)
 {
-	if ( m_CurrentDirectory == Directory::AUDIO || m_CurrentDirectory == Directory::MIDI || m_CurrentDirectory == Directory::SCENE )
+	// the file manager stays in the directory until told otherwise
+	if ( directory == m_CurrentDirectory ) return true;
+
+	if ( m_CurrentDirectory != Directory::ROOT )
 	{
 		// go back to root directory
 		m_FileManager.returnToRoot();
-	}
-
-	char dirName[FAT16_FILENAME_SIZE + 1] = { '\0' };
-	unsigned int numChars = 0;
-	if ( directory == Directory::AUDIO )
-	{
-		strcpy( dirName, "AUDIO" );
-		numChars = 5;
-	}
-	else if ( directory == Directory::MIDI )
-	{
-		strcpy( dirName, "MIDI" );
-		numChars = 4;
-	}
-	else if ( directory == Directory::SCENE )
-	{
-		strcpy( dirName, "SCENE" );
-		numChars = 5;
+		m_CurrentDirectory = Directory::ROOT;
 	}
 
 	if ( directory != Directory::ROOT )
 	{
 		unsigned int entryNum = 0;
-		for ( Fat16Entry* entry : m_FileManager.getCurrentDirectoryEntries() )
+		if ( this->getDirectoryIndex(Directory::ROOT).findRaw(DirectoryNameRaw(directory), "   ", entryNum) )
 		{
-			if ( strncmp(entry->getFilenameRaw(), dirName, numChars) == 0 )
-			{
-				m_FileManager.selectEntry( entryNum );
-				m_CurrentDirectory = directory;
-				return true;
-			}
-
-			entryNum++;
+			m_FileManager.selectEntry( entryNum );
+			m_CurrentDirectory = directory;
+			return true;
 		}
 
 		// we haven't found the directory, so send invalid filesystem message and return false
@@ -900,6 +1275,42 @@ bool MnemonicAudioManager::goToDirectory (const Directory& directory)
 	return true;
 }
 
+Fat16DirectoryIndex& MnemonicAudioManager::getDirectoryIndex (const Directory& directory)
+{
+	return m_DirectoryIndices[static_cast<unsigned int>(directory)];
+}
+
+bool MnemonicAudioManager::createEntry (Fat16Entry& entry)
+{
+	if ( ! m_FileManager.createEntry(entry) ) return false;
+
+	// the new entry may have taken the place of a deleted one, so look for it from the end where new entries usually go
+	std::vector<Fat16Entry*>& dirEntries = m_FileManager.getCurrentDirectoryEntries();
+	for ( unsigned int entryNum = dirEntries.size(); entryNum > 0; entryNum-- )
+	{
+		const Fat16Entry* entryInDir = dirEntries[entryNum - 1];
+		if ( ! entryInDir->isDeletedEntry() && strncmp(entryInDir->getFilenameRaw(), entry.getFilenameRaw(), FAT16_FILENAME_SIZE) == 0
+				&& strncmp(entryInDir->getExtensionRaw(), entry.getExtensionRaw(), FAT16_EXTENSION_SIZE) == 0 )
+		{
+			this->getDirectoryIndex( m_CurrentDirectory ).insert( *entryInDir, entryNum - 1 );
+			this->addToFileExplorerListing( m_CurrentDirectory, *entryInDir, entryNum - 1 );
+
+			break;
+		}
+	}
+
+	return true;
+}
+
+void MnemonicAudioManager::deleteEntry (unsigned int index)
+{
+	std::vector<Fat16Entry*>& dirEntries = m_FileManager.getCurrentDirectoryEntries();
+	if ( index < dirEntries.size() ) this->getDirectoryIndex( m_CurrentDirectory ).remove( *dirEntries[index] );
+	this->removeFromFileExplorerListing( m_CurrentDirectory, index );
+
+	m_FileManager.deleteEntry( index );
+}
+
 bool MnemonicAudioManager::loadSceneFileHelper (const std::string& versionStr, std::string& sceneStr)
 {
 	if ( versionStr == "1.0.0" )
@@ -943,23 +1354,11 @@ bool MnemonicAudioManager::loadAudioFileHelper (const std::string& filename, uns
 {
 	if ( ! this->goToDirectory(Directory::AUDIO) ) return false;
 
+	// the index ignores case, so either case of the extension is found
 	unsigned int index = 0;
-	for ( const Fat16Entry* entry : m_FileManager.getCurrentDirectoryEntries() )
-	{
-		std::string filenameUppercaseExt = filename;
-		std::string filenameLowercaseExt = filename;
-		filenameUppercaseExt.replace( filenameUppercaseExt.find(".") + 1, 3, "B12" );
-		filenameLowercaseExt.replace( filenameLowercaseExt.find(".") + 1, 3, "b12" );
-		if ( strcmp(entry->getFilenameDisplay(), filenameUppercaseExt.c_str()) == 0
-			|| strcmp(entry->getFilenameDisplay(), filenameLowercaseExt.c_str()) == 0 )
-		{
-			return this->loadAudioFileHelper( index, cellX, cellY, false );
-		}
-
-		index++;
-	}
+	if ( ! this->getDirectoryIndex(Directory::AUDIO).find(filename.c_str(), index, "B12") ) return false;
 
-	return false;
+	return this->loadAudioFileHelper( index, cellX, cellY, false );
 }
 
 bool MnemonicAudioManager::loadAudioFileHelper (unsigned int index, unsigned int cellX, unsigned int cellY, bool loadStereo)
@@ -974,25 +1373,72 @@ bool MnemonicAudioManager::loadAudioFileHelper (unsigned int index, unsigned int
 	if ( ! entry->isDeletedEntry() && (strncmp(entry->getExtensionRaw(), "b12", FAT16_EXTENSION_SIZE) == 0
 		|| strncmp(entry->getExtensionRaw(), "B12", FAT16_EXTENSION_SIZE) == 0) )
 	{
-		AudioTrack trackL( cellX, cellY, &m_FileManager, *entry, m_FileManager.getActiveBootSector()->getSectorSizeInBytes(),
-					m_AxiSramAllocator, m_DecompressedBuffer );
-		AudioTrack trackR( cellX, cellY, &m_FileManager, (entryOtherChannel) ? *entryOtherChannel : *entry,
-					m_FileManager.getActiveBootSector()->getSectorSizeInBytes(), m_AxiSramAllocator,
-					m_DecompressedBuffer );
+		const unsigned int sectorSizeInBytes = m_FileManager.getActiveBootSector()->getSectorSizeInBytes();
 
-		m_AudioTracks.push_back( trackL );
-		AudioTrack& trackLRef = m_AudioTracks[m_AudioTracks.size() - 1];
-		const bool isOneshot = static_cast<MNEMONIC_ROW>( cellY ) == MNEMONIC_ROW::AUDIO_ONESHOTS;
-		if ( ! isOneshot ) trackLRef.setLoopLength( m_CurrentMaxLoopCount );
+		const unsigned int startingClusterL = Fat16SectorStream::FindStartingCluster( m_SdCard, m_Fat16Geometry, m_AudioDirectoryCluster,
+												entry->getFilenameRaw(), entry->getExtensionRaw() );
+		if ( startingClusterL == 0 ) return false;
+
+		Fat16SectorStream streamL( m_SdCard, m_Fat16Geometry, startingClusterL, entry->getFileSizeInBytes() );
+		unsigned int numChannelsL = 1;
+		unsigned int sampleRateL = MNEMONIC_SAMPLE_RATE;
+		if ( ! this->readB12ContainerHeader(streamL, numChannelsL, sampleRateL) ) return false;
+
+		// an interleaved stereo file already holds both channels
+		if ( numChannelsL == 2 ) entryOtherChannel = nullptr;
+
+		AudioTrack trackL( cellX, cellY, streamL, *m_AsyncSdCard, *entry, numChannelsL, sectorSizeInBytes, m_AxiSramAllocator,
+					sampleRateL, m_SampleRate );
+
+		// the other channel's stream, ring, extent map and resampler are only built when there is another channel
 		if ( entryOtherChannel )
 		{
-			trackLRef.setAmplitudes( 1.0f, 0.0f );
+			const unsigned int startingClusterR = Fat16SectorStream::FindStartingCluster( m_SdCard, m_Fat16Geometry,
+													m_AudioDirectoryCluster,
+													entryOtherChannel->getFilenameRaw(),
+													entryOtherChannel->getExtensionRaw() );
+			if ( startingClusterR == 0 ) return false;
+
+			Fat16SectorStream streamR( m_SdCard, m_Fat16Geometry, startingClusterR, entryOtherChannel->getFileSizeInBytes() );
+			unsigned int numChannelsR = 1;
+			unsigned int sampleRateR = sampleRateL;
+			if ( ! this->readB12ContainerHeader(streamR, numChannelsR, sampleRateR) || numChannelsR != 1 ) return false;
+
+			AudioTrack trackR( cellX, cellY, streamR, *m_AsyncSdCard, *entryOtherChannel, numChannelsR, sectorSizeInBytes,
+						m_AxiSramAllocator, sampleRateR, m_SampleRate );
+			trackL.setAmplitudes( 1.0f, 0.0f );
+			trackR.setAmplitudes( 0.0f, 1.0f );
+			m_AudioTracks.push_back( trackL );
 			m_AudioTracks.push_back( trackR );
-			AudioTrack& trackRRef = m_AudioTracks[m_AudioTracks.size() - 1];
-			if ( ! isOneshot ) trackRRef.setLoopLength( m_CurrentMaxLoopCount );
-			trackRRef.setAmplitudes( 0.0f, 1.0f );
+		}
+		else
+		{
+			m_AudioTracks.push_back( trackL );
+		}
+
+		const unsigned int numTracksLoaded = ( entryOtherChannel ) ? 2 : 1;
+		const unsigned int firstTrackIndex = m_AudioTracks.size() - numTracksLoaded;
+		const bool isOneshot = static_cast<MNEMONIC_ROW>( cellY ) == MNEMONIC_ROW::AUDIO_ONESHOTS;
+		if ( isOneshot )
+		{
+			// one-shots are played from memory when possible, so a trigger never waits on the sd card
+			this->cacheOneshotTracks( firstTrackIndex, numTracksLoaded );
+		}
+		else
+		{
+			// loops restart from the start of the file kept in memory, so a loop boundary never waits on the sd card either
+			for ( unsigned int track = firstTrackIndex; track < m_AudioTracks.size(); track++ )
+			{
+				AudioTrack& audioTrack = m_AudioTracks[track];
+				audioTrack.setLoopLength( m_CurrentMaxLoopCount );
+				audioTrack.loadLoopHead( (MNEMONIC_LOOP_HEAD_RING_UNITS * audioTrack.getRingUnitSizeInBytes()) / sectorSizeInBytes );
+			}
 		}
 
+		this->resizeAudioTrackRings();
+		// resizing lands reads in flight, which may finish a track
+		m_LoopingInfoChanged = true;
+
 		IMnemonicUiEventListener::PublishEvent(
 				MnemonicUiEvent(UiEventType::SCENE_TRACK_FILE_LOADED, nullptr, 0, 0, cellX, cellY) );
 
@@ -1002,27 +1448,30 @@ bool MnemonicAudioManager::loadAudioFileHelper (unsigned int index, unsigned int
 	return false;
 }
 
+bool MnemonicAudioManager::readB12ContainerHeader (Fat16SectorStream& stream, unsigned int& numChannels, unsigned int& sampleRate)
+{
+	SharedData<uint8_t> firstSector = m_SdCard.readFromMedia( stream.getSectorSizeInBytes(), stream.getStartingAddress() );
+
+	B12ContainerHeader header;
+	if ( ! B12ReadContainerHeader(&firstSector[0], firstSector.getSize(), header) ) return false;
+
+	stream.setDataOffset( header.m_HeaderSizeInBytes / stream.getSectorSizeInBytes() );
+	numChannels = header.m_NumChannels;
+	// plain files and version 1 headers don't record a rate, they were always encoded at the engine's rate
+	sampleRate = ( header.m_SampleRate != 0 ) ? header.m_SampleRate : MNEMONIC_SAMPLE_RATE;
+
+	return true;
+}
+
 bool MnemonicAudioManager::loadMidiFileHelper (const std::string& filename, unsigned int cellX, unsigned int cellY)
 {
 	if ( ! this->goToDirectory(Directory::MIDI) ) return false;
 
+	// the index ignores case, so either case of the extension is found
 	unsigned int index = 0;
-	for ( const Fat16Entry* entry : m_FileManager.getCurrentDirectoryEntries() )
-	{
-		std::string filenameUppercaseExt = filename;
-		std::string filenameLowercaseExt = filename;
-		filenameUppercaseExt.replace( filenameUppercaseExt.find(".") + 1, 3, "smf" );
-		filenameLowercaseExt.replace( filenameLowercaseExt.find(".") + 1, 3, "SMF" );
-		if ( strcmp(entry->getFilenameDisplay(), filenameUppercaseExt.c_str()) == 0
-			|| strcmp(entry->getFilenameDisplay(), filenameLowercaseExt.c_str()) == 0 )
-		{
-			return this->loadMidiFileHelper( index, cellX, cellY );
-		}
+	if ( ! this->getDirectoryIndex(Directory::MIDI).find(filename.c_str(), index, "SMF") ) return false;
 
-		index++;
-	}
-
-	return false;
+	return this->loadMidiFileHelper( index, cellX, cellY );
 }
 
 bool MnemonicAudioManager::loadMidiFileHelper (unsigned int index, unsigned int cellX, unsigned int cellY)
@@ -1068,6 +1517,9 @@ bool MnemonicAudioManager::loadMidiFileHelper (unsigned int index, unsigned int
 		// deallocate the primitive array
 		m_AxiSramAllocator.free( midiTrackEventPrimArr );
 
+		// no audio track's ring depends on a midi track, only the loop boundaries do
+		this->rebuildLoopCalendar();
+
 		IMnemonicUiEventListener::PublishEvent(
 				MnemonicUiEvent(UiEventType::SCENE_TRACK_FILE_LOADED, nullptr, 0, 0, cellX, cellY) );
 
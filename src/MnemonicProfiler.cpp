@@ -0,0 +1,127 @@
+#include "MnemonicProfiler.hpp"
+
+#ifdef MNEMONIC_PROFILING
+
+#include "AudioConstants.hpp"
+#include "MnemonicConstants.hpp"
+
+#ifdef TARGET_BUILD
+// cortex-m7 debug registers, see the armv7-m architecture reference manual
+static volatile uint32_t* const DEMCR = reinterpret_cast<volatile uint32_t*>( 0xE000EDFC );
+static volatile uint32_t* const DWT_CTRL = reinterpret_cast<volatile uint32_t*>( 0xE0001000 );
+static volatile uint32_t* const DWT_CYCCNT = reinterpret_cast<volatile uint32_t*>( 0xE0001004 );
+static volatile uint32_t* const DWT_LAR = reinterpret_cast<volatile uint32_t*>( 0xE0001FB0 );
+constexpr uint32_t DEMCR_TRCENA = 1 << 24;
+constexpr uint32_t DWT_CTRL_CYCCNTENA = 1 << 0;
+constexpr uint32_t DWT_LAR_UNLOCK = 0xC5ACCE55;
+#else
+#include <chrono>
+#endif // TARGET_BUILD
+
+uint32_t MnemonicProfiler::m_TicksPerSecond = 1000000000;
+ProfileStats MnemonicProfiler::m_Stats[MNEMONIC_PROFILE_NUM_SCOPES];
+uint32_t MnemonicProfiler::m_BlockTicks[MNEMONIC_PROFILE_NUM_SCOPES] = { 0 };
+bool MnemonicProfiler::m_RanThisBlock[MNEMONIC_PROFILE_NUM_SCOPES] = { false };
+
+void MnemonicProfiler::Enable (uint32_t coreClockFrequency)
+{
+#ifdef TARGET_BUILD
+	*DEMCR |= DEMCR_TRCENA;
+	*DWT_LAR = DWT_LAR_UNLOCK;
+	*DWT_CYCCNT = 0;
+	*DWT_CTRL |= DWT_CTRL_CYCCNTENA;
+
+	m_TicksPerSecond = coreClockFrequency;
+#else
+	// the host always counts nanoseconds
+	(void) coreClockFrequency;
+#endif // TARGET_BUILD
+
+	Reset();
+}
+
+void MnemonicProfiler::Reset()
+{
+	for ( unsigned int scope = 0; scope < MNEMONIC_PROFILE_NUM_SCOPES; scope++ )
+	{
+		m_Stats[scope].m_MinTicks = UINT32_MAX;
+		m_Stats[scope].m_MaxTicks = 0;
+		m_Stats[scope].m_TotalTicks = 0;
+		m_Stats[scope].m_NumBlocks = 0;
+		m_BlockTicks[scope] = 0;
+		m_RanThisBlock[scope] = false;
+	}
+}
+
+uint32_t MnemonicProfiler::GetTicks()
+{
+#ifdef TARGET_BUILD
+	return *DWT_CYCCNT;
+#else
+	// only differences are used, so wrapping around every few seconds is fine
+	return static_cast<uint32_t>( std::chrono::duration_cast<std::chrono::nanoseconds>(
+					std::chrono::steady_clock::now().time_since_epoch()).count() );
+#endif // TARGET_BUILD
+}
+
+void MnemonicProfiler::AddToBlock (const ProfileScope scope, uint32_t ticks)
+{
+	m_BlockTicks[static_cast<unsigned int>(scope)] += ticks;
+	m_RanThisBlock[static_cast<unsigned int>(scope)] = true;
+}
+
+void MnemonicProfiler::EndBlock()
+{
+	for ( unsigned int scope = 0; scope < MNEMONIC_PROFILE_NUM_SCOPES; scope++ )
+	{
+		if ( ! m_RanThisBlock[scope] ) continue;
+
+		ProfileStats& stats = m_Stats[scope];
+		const uint32_t ticks = m_BlockTicks[scope];
+		if ( ticks < stats.m_MinTicks ) stats.m_MinTicks = ticks;
+		if ( ticks > stats.m_MaxTicks ) stats.m_MaxTicks = ticks;
+		stats.m_TotalTicks += ticks;
+		stats.m_NumBlocks++;
+
+		m_BlockTicks[scope] = 0;
+		m_RanThisBlock[scope] = false;
+	}
+}
+
+uint32_t MnemonicProfiler::GetAverageTicks (const ProfileScope scope)
+{
+	const ProfileStats& stats = GetStats( scope );
+	if ( stats.m_NumBlocks == 0 ) return 0;
+
+	return static_cast<uint32_t>( stats.m_TotalTicks / stats.m_NumBlocks );
+}
+
+float MnemonicProfiler::GetWorstBlockPercentOfDeadline (const ProfileScope scope)
+{
+	const uint64_t deadlineTicks = ( static_cast<uint64_t>(m_TicksPerSecond) * ABUFFER_SIZE ) / MNEMONIC_SAMPLE_RATE;
+
+	return ( static_cast<float>(GetStats(scope).m_MaxTicks) * 100.0f ) / static_cast<float>( deadlineTicks );
+}
+
+const char* MnemonicProfiler::GetScopeName (const ProfileScope scope)
+{
+	switch ( scope )
+	{
+		case ProfileScope::AUDIO_MANAGER_CALL:
+			return "MnemonicAudioManager::call";
+		case ProfileScope::AUDIO_TRACK_CALL:
+			return "AudioTrack::call";
+		case ProfileScope::B12_DECODE_MIX:
+			return "B12DecodeMix";
+		case ProfileScope::RESAMPLE:
+			return "PolyphaseResampler::process";
+		case ProfileScope::MIDI_TRACK_EVENTS:
+			return "MidiTrack::addMidiEventsAtTimeCode";
+		case ProfileScope::RESET_LOOPING_INFO:
+			return "MnemonicAudioManager::resetLoopingInfo";
+		default:
+			return "unknown";
+	}
+}
+
+#endif // MNEMONIC_PROFILING
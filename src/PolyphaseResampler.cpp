@@ -0,0 +1,200 @@
+#include "PolyphaseResampler.hpp"
+
+#include <cmath>
+#include <cstring>
+
+#if defined( __ARM_FEATURE_SIMD32 )
+#include <arm_acle.h>
+#endif
+
+constexpr uint32_t FRACTION_ONE = 1 << POLYPHASE_RESAMPLER_FRACTION_BITS;
+constexpr uint32_t FRACTION_MASK = FRACTION_ONE - 1;
+constexpr unsigned int PHASE_SHIFT = POLYPHASE_RESAMPLER_FRACTION_BITS - POLYPHASE_RESAMPLER_PHASE_BITS;
+constexpr unsigned int CENTRE_TAP = ( POLYPHASE_RESAMPLER_NUM_TAPS / 2 ) - 1; // the tap on the source frame at or before the output
+constexpr int32_t UNITY_COEFFICIENT = 1 << 14;
+constexpr float CUTOFF = 0.9f; // of the nyquist frequency of the slower rate, the rest is left for the filter's transition band
+constexpr float PI = 3.14159265358979f;
+
+static_assert( POLYPHASE_RESAMPLER_NUM_TAPS % 2 == 0, "taps are multiplied in pairs" );
+
+PolyphaseResampler::PolyphaseResampler() :
+	m_Coefficients(),
+	m_History(),
+	m_HistorySize( 0 ),
+	m_NumChannels( 1 ),
+	m_NumFrames( 0 ),
+	m_Step( 0 ),
+	m_Fraction( 0 )
+{
+}
+
+PolyphaseResampler::~PolyphaseResampler()
+{
+}
+
+bool PolyphaseResampler::configure (unsigned int sourceRate, unsigned int outputRate, unsigned int numChannels,
+					unsigned int maxOutputFrames, unsigned int maxPushFrames, IAllocator* allocator)
+{
+	m_Step = 0;
+
+	if ( sourceRate == outputRate || sourceRate == 0 || outputRate == 0 || sourceRate > outputRate * POLYPHASE_RESAMPLER_MAX_RATIO
+		|| numChannels == 0 || numChannels > 2 )
+	{
+		return false;
+	}
+
+	m_NumChannels = numChannels;
+	// a block never needs more than MAX_RATIO source frames per output frame, plus the taps and whatever was pushed past that
+	m_HistorySize = ( maxOutputFrames * POLYPHASE_RESAMPLER_MAX_RATIO ) + POLYPHASE_RESAMPLER_NUM_TAPS + maxPushFrames + 1;
+	m_History = SharedData<int16_t>::MakeSharedData( m_HistorySize * numChannels, allocator );
+	m_Coefficients = SharedData<int16_t>::MakeSharedData( POLYPHASE_RESAMPLER_NUM_PHASES * POLYPHASE_RESAMPLER_NUM_TAPS, allocator );
+
+	// when downsampling, the cutoff moves down to the output's nyquist frequency
+	const float rateRatio = static_cast<float>( outputRate ) / static_cast<float>( sourceRate );
+	this->buildCoefficients( (rateRatio < 1.0f) ? CUTOFF * rateRatio : CUTOFF );
+
+	m_Step = static_cast<uint32_t>( (static_cast<uint64_t>(sourceRate) << POLYPHASE_RESAMPLER_FRACTION_BITS) / outputRate );
+	this->reset();
+
+	return true;
+}
+
+void PolyphaseResampler::buildCoefficients (float cutoff)
+{
+	for ( unsigned int phase = 0; phase < POLYPHASE_RESAMPLER_NUM_PHASES; phase++ )
+	{
+		const float fraction = static_cast<float>( phase ) / POLYPHASE_RESAMPLER_NUM_PHASES;
+		const float halfSpan = POLYPHASE_RESAMPLER_NUM_TAPS / 2.0f;
+
+		// a blackman windowed sinc, centred between the centre tap and the one after it by the phase's fraction
+		float taps[POLYPHASE_RESAMPLER_NUM_TAPS];
+		float tapsSum = 0.0f;
+		for ( unsigned int tap = 0; tap < POLYPHASE_RESAMPLER_NUM_TAPS; tap++ )
+		{
+			const float time = static_cast<float>( static_cast<int>(tap) - static_cast<int>(CENTRE_TAP) ) - fraction;
+			const float sincArg = PI * cutoff * time;
+			const float sinc = ( time == 0.0f ) ? 1.0f : std::sin( sincArg ) / sincArg;
+			const float window = 0.42f + ( 0.5f * std::cos(PI * time / halfSpan) ) + ( 0.08f * std::cos(2.0f * PI * time / halfSpan) );
+			taps[tap] = sinc * window;
+			tapsSum += taps[tap];
+		}
+
+		// each phase is normalised to unity on its own so that dc doesn't ripple with the phase, the rounding error goes to
+		// the biggest tap
+		int16_t* coefficients = &m_Coefficients[phase * POLYPHASE_RESAMPLER_NUM_TAPS];
+		int32_t coefficientsSum = 0;
+		unsigned int biggestTap = 0;
+		for ( unsigned int tap = 0; tap < POLYPHASE_RESAMPLER_NUM_TAPS; tap++ )
+		{
+			coefficients[tap] = static_cast<int16_t>( std::lround((taps[tap] / tapsSum) * UNITY_COEFFICIENT) );
+			coefficientsSum += coefficients[tap];
+			if ( coefficients[tap] > coefficients[biggestTap] ) biggestTap = tap;
+		}
+		coefficients[biggestTap] += UNITY_COEFFICIENT - coefficientsSum;
+	}
+}
+
+void PolyphaseResampler::reset()
+{
+	if ( ! this->isActive() ) return;
+
+	// silence before the first source frame, so the first output lands right on it
+	std::memset( &m_History[0], 0, m_HistorySize * m_NumChannels * sizeof(int16_t) );
+	m_NumFrames = CENTRE_TAP;
+	m_Fraction = 0;
+}
+
+unsigned int PolyphaseResampler::getSourceFramesNeeded (unsigned int numOutputFrames) const
+{
+	if ( numOutputFrames == 0 ) return 0;
+
+	const uint64_t lastPosition = static_cast<uint64_t>( m_Fraction ) + ( static_cast<uint64_t>(m_Step) * (numOutputFrames - 1) );
+	const unsigned int framesNeeded = static_cast<unsigned int>( lastPosition >> POLYPHASE_RESAMPLER_FRACTION_BITS )
+						+ POLYPHASE_RESAMPLER_NUM_TAPS;
+
+	return ( framesNeeded > m_NumFrames ) ? framesNeeded - m_NumFrames : 0;
+}
+
+void PolyphaseResampler::pushSourceFrames (const int32_t* framesL, const int32_t* framesR, unsigned int numFrames)
+{
+	const unsigned int framesFree = m_HistorySize - m_NumFrames;
+	numFrames = ( numFrames < framesFree ) ? numFrames : framesFree;
+
+	const int32_t* channelFrames[2] = { framesL, framesR };
+	for ( unsigned int channel = 0; channel < m_NumChannels; channel++ )
+	{
+		int16_t* history = &m_History[(channel * m_HistorySize) + m_NumFrames];
+		for ( unsigned int frame = 0; frame < numFrames; frame++ )
+		{
+			history[frame] = static_cast<int16_t>( channelFrames[channel][frame] );
+		}
+	}
+
+	m_NumFrames += numFrames;
+}
+
+static inline int32_t filterFrame (const int16_t* history, const int16_t* coefficients)
+{
+#if defined( __ARM_FEATURE_SIMD32 )
+	// two taps per multiply accumulate
+	int32_t accumulator = 0;
+	for ( unsigned int tap = 0; tap < POLYPHASE_RESAMPLER_NUM_TAPS; tap += 2 )
+	{
+		int16x2_t historyPair;
+		int16x2_t coefficientPair;
+		std::memcpy( &historyPair, &history[tap], sizeof(historyPair) );
+		std::memcpy( &coefficientPair, &coefficients[tap], sizeof(coefficientPair) );
+		accumulator = __smlad( historyPair, coefficientPair, accumulator );
+	}
+#else
+	int32_t accumulator = 0;
+	for ( unsigned int tap = 0; tap < POLYPHASE_RESAMPLER_NUM_TAPS; tap++ )
+	{
+		accumulator += static_cast<int32_t>( history[tap] ) * coefficients[tap];
+	}
+#endif
+
+	// 11-bit samples with q14 coefficients, the overshoot of the filter leaves plenty of headroom in 32 bits
+	return accumulator >> 14;
+}
+
+void PolyphaseResampler::process (unsigned int numOutputFrames, int32_t* busL, int32_t* busR, int16_t gainL, int16_t gainR)
+{
+	if ( ! this->isActive() || this->getSourceFramesNeeded(numOutputFrames) > 0 ) return;
+
+	const int16_t* historyL = &m_History[0];
+	const int16_t* historyR = ( m_NumChannels == 2 ) ? &m_History[m_HistorySize] : historyL;
+
+	unsigned int frameIndex = 0;
+	uint32_t fraction = m_Fraction;
+	for ( unsigned int frame = 0; frame < numOutputFrames; frame++ )
+	{
+		const int16_t* coefficients = &m_Coefficients[(fraction >> PHASE_SHIFT) * POLYPHASE_RESAMPLER_NUM_TAPS];
+
+		if ( m_NumChannels == 2 )
+		{
+			busL[frame] += ( filterFrame(&historyL[frameIndex], coefficients) * gainL ) >> 14;
+			busR[frame] += ( filterFrame(&historyR[frameIndex], coefficients) * gainR ) >> 14;
+		}
+		else
+		{
+			// a single channel feeds both buses, as it does for B12DecodeMix
+			const int32_t sample = filterFrame( &historyL[frameIndex], coefficients );
+			busL[frame] += ( sample * gainL ) >> 14;
+			busR[frame] += ( sample * gainR ) >> 14;
+		}
+
+		fraction += m_Step;
+		frameIndex += fraction >> POLYPHASE_RESAMPLER_FRACTION_BITS;
+		fraction &= FRACTION_MASK;
+	}
+
+	// drop the frames the block moved past, the rest are the first taps of the next block
+	m_NumFrames -= frameIndex;
+	for ( unsigned int channel = 0; channel < m_NumChannels; channel++ )
+	{
+		int16_t* history = &m_History[channel * m_HistorySize];
+		std::memmove( history, &history[frameIndex], m_NumFrames * sizeof(int16_t) );
+	}
+	m_Fraction = fraction;
+}
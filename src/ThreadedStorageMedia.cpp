@@ -0,0 +1,115 @@
+#include "ThreadedStorageMedia.hpp"
+
+#ifndef TARGET_BUILD
+
+ThreadedStorageMedia::ThreadedStorageMedia (const std::string& imageFilename, unsigned int numWorkers) :
+	m_Requests(),
+	m_QueuedRequests{ 0 },
+	m_QueueReadIndex( 0 ),
+	m_NumQueued( 0 ),
+	m_Mutex(),
+	m_RequestQueued(),
+	m_RequestCompleted(),
+	m_ShouldStop( false ),
+	m_Files(),
+	m_Workers()
+{
+	for ( unsigned int worker = 0; worker < numWorkers; worker++ )
+	{
+		m_Files.emplace_back( new std::ifstream(imageFilename, std::ios::in | std::ios::binary) );
+		m_Workers.emplace_back( &ThreadedStorageMedia::workerLoop, this, m_Files.back().get() );
+	}
+}
+
+ThreadedStorageMedia::~ThreadedStorageMedia()
+{
+	{
+		std::lock_guard<std::mutex> lock( m_Mutex );
+		m_ShouldStop = true;
+	}
+	m_RequestQueued.notify_all();
+
+	for ( std::thread& worker : m_Workers )
+	{
+		worker.join();
+	}
+}
+
+unsigned int ThreadedStorageMedia::submitRead (uint8_t* destination, unsigned int sizeInBytes, unsigned int byteAddress)
+{
+	std::unique_lock<std::mutex> lock( m_Mutex );
+
+	for ( unsigned int requestId = 0; requestId < ASYNC_STORAGE_MAX_REQUESTS; requestId++ )
+	{
+		Request& request = m_Requests[requestId];
+		if ( request.m_State == RequestState::FREE )
+		{
+			request.m_Destination = destination;
+			request.m_SizeInBytes = sizeInBytes;
+			request.m_ByteAddress = byteAddress;
+			request.m_State = RequestState::QUEUED;
+
+			m_QueuedRequests[(m_QueueReadIndex + m_NumQueued) % ASYNC_STORAGE_MAX_REQUESTS] = requestId;
+			m_NumQueued++;
+
+			lock.unlock();
+			m_RequestQueued.notify_one();
+
+			return requestId;
+		}
+	}
+
+	return ASYNC_STORAGE_INVALID_REQUEST;
+}
+
+bool ThreadedStorageMedia::pollRead (unsigned int requestId)
+{
+	std::lock_guard<std::mutex> lock( m_Mutex );
+
+	Request& request = m_Requests[requestId];
+	if ( request.m_State == RequestState::COMPLETE )
+	{
+		request.m_State = RequestState::FREE;
+
+		return true;
+	}
+
+	return false;
+}
+
+void ThreadedStorageMedia::waitForRead (unsigned int requestId)
+{
+	std::unique_lock<std::mutex> lock( m_Mutex );
+
+	Request& request = m_Requests[requestId];
+	m_RequestCompleted.wait( lock, [&request]() { return request.m_State == RequestState::COMPLETE; } );
+	request.m_State = RequestState::FREE;
+}
+
+void ThreadedStorageMedia::workerLoop (std::ifstream* file)
+{
+	while ( true )
+	{
+		std::unique_lock<std::mutex> lock( m_Mutex );
+		m_RequestQueued.wait( lock, [this]() { return m_ShouldStop || m_NumQueued > 0; } );
+		if ( m_ShouldStop ) return;
+
+		const unsigned int requestId = m_QueuedRequests[m_QueueReadIndex];
+		m_QueueReadIndex = ( m_QueueReadIndex + 1 ) % ASYNC_STORAGE_MAX_REQUESTS;
+		m_NumQueued--;
+		const Request request = m_Requests[requestId];
+		lock.unlock();
+
+		// the read itself happens outside of the lock so other workers and the submitting thread can carry on
+		file->clear();
+		file->seekg( request.m_ByteAddress );
+		file->read( reinterpret_cast<char*>(request.m_Destination), request.m_SizeInBytes );
+
+		lock.lock();
+		m_Requests[requestId].m_State = RequestState::COMPLETE;
+		lock.unlock();
+		m_RequestCompleted.notify_all();
+	}
+}
+
+#endif // TARGET_BUILD
@@ -0,0 +1,58 @@
+#include "WireRateMidiOutputQueue.hpp"
+
+#ifndef TARGET_BUILD
+
+constexpr int32_t ONE_SAMPLE = 256;
+
+WireRateMidiOutputQueue::WireRateMidiOutputQueue (unsigned int sampleRate) :
+	MidiOutputQueue(),
+	m_ByteTime( 0 ),
+	m_TimeLeftOnWire( 0 ),
+	m_ByteIsOnWire( false ),
+	m_ByteOnWire( 0 )
+{
+	this->setSampleRate( sampleRate );
+}
+
+WireRateMidiOutputQueue::~WireRateMidiOutputQueue()
+{
+}
+
+void WireRateMidiOutputQueue::setSampleRate (unsigned int sampleRate)
+{
+	m_ByteTime = static_cast<int32_t>( (static_cast<uint64_t>(sampleRate) * MIDI_WIRE_BITS_PER_BYTE * ONE_SAMPLE)
+						/ MIDI_WIRE_BAUD_RATE );
+}
+
+bool WireRateMidiOutputQueue::tick (uint8_t& byteSent)
+{
+	bool byteWasSent = false;
+	if ( m_ByteIsOnWire )
+	{
+		m_TimeLeftOnWire -= ONE_SAMPLE;
+		if ( m_TimeLeftOnWire <= 0 )
+		{
+			byteSent = m_ByteOnWire;
+			byteWasSent = true;
+			m_ByteIsOnWire = false;
+		}
+	}
+
+	if ( ! m_ByteIsOnWire )
+	{
+		if ( this->readByte(m_ByteOnWire) )
+		{
+			// the next byte starts right as the last one ends, so whatever the last one overran by comes off this one
+			m_TimeLeftOnWire += m_ByteTime;
+			m_ByteIsOnWire = true;
+		}
+		else
+		{
+			m_TimeLeftOnWire = 0; // the wire sits idle
+		}
+	}
+
+	return byteWasSent;
+}
+
+#endif // TARGET_BUILD
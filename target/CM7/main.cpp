@@ -5,15 +5,24 @@
 #include "SDCard.hpp"
 #include "EventQueue.hpp"
 #include "MidiHandler.hpp"
+#include "MidiSampleClock.hpp"
+#include "MidiOutputScheduler.hpp"
+#include "MidiOutputQueue.hpp"
 #include "MnemonicAudioManager.hpp"
 #include "AudioBuffer.hpp"
 #include "AudioConstants.hpp"
 #include "IMnemonicUiEventListener.hpp"
+#include "MnemonicProfiler.hpp"
 
 const int SYS_CLOCK_FREQUENCY = 480000000;
 
+class UsartMidiOutputQueue;
+
 // global variables
 MidiHandler* volatile midiHandlerPtr = nullptr;
+MidiSampleClock* volatile midiSampleClockPtr = nullptr;
+MidiOutputScheduler* volatile midiOutputSchedulerPtr = nullptr;
+UsartMidiOutputQueue* volatile midiOutputQueuePtr = nullptr;
 AudioBuffer<int16_t, true>* volatile audioBufferPtr = nullptr;
 
 // peripheral defines
@@ -59,6 +68,7 @@ AudioBuffer<int16_t, true>* volatile audioBufferPtr = nullptr;
 #define OLED_DC_PIN 			GPIO_PIN::PIN_14
 #define OLED_CS_PIN 			GPIO_PIN::PIN_11
 #define MIDI_USART_NUM 			USART_NUM::USART_6
+#define MIDI_USART 			USART6 // for the transmit interrupt, which is driven through the registers directly
 #define LOGGING_USART_NUM 		USART_NUM::USART_2
 #define EEPROM_I2C_NUM 			I2C_NUM::I2C_1
 #define SRAM_SPI_NUM 			SPI_NUM::SPI_2
@@ -155,6 +165,38 @@ class MnemonicUiEventBridge : public IMnemonicUiEventListener
 		EventQueue<MnemonicUiEvent>* m_EventQueuePtr;
 };
 
+// this class is to send the midi output queue a byte at a time from the usart's transmit empty interrupt, which is only enabled
+// while there are bytes to send
+class UsartMidiOutputQueue : public MidiOutputQueue
+{
+	public:
+		UsartMidiOutputQueue() : MidiOutputQueue() {}
+		~UsartMidiOutputQueue() override {}
+
+		// from the usart interrupt when the transmit data register is empty
+		void transmitNextByte()
+		{
+			uint8_t byte = 0;
+			if ( this->readByte(byte) )
+			{
+				MIDI_USART->TDR = byte;
+			}
+			else
+			{
+				MIDI_USART->CR1 &= ~USART_CR1_TXEIE_TXFNFIE;
+
+				// a write may have landed between the read and disabling the interrupt, it would wait for the next write otherwise
+				if ( ! this->isEmpty() ) MIDI_USART->CR1 |= USART_CR1_TXEIE_TXFNFIE;
+			}
+		}
+
+	protected:
+		void onBytesWritten() override
+		{
+			MIDI_USART->CR1 |= USART_CR1_TXEIE_TXFNFIE;
+		}
+};
+
 // these pins are unused for mnemonic, so we disable them as per the ST recommendations
 void disableUnusedPins()
 {
@@ -410,6 +452,14 @@ int main(void)
 
 	// LLPD::usart_log( LOGGING_USART_NUM, "Ultra_FX_SYN setup complete, entering while loop -------------------------------" );
 
+	// setup midi timing, the clock is only ticked once the audio buffer is connected below
+	MidiSampleClock midiSampleClock;
+	midiSampleClockPtr = &midiSampleClock;
+	MidiOutputScheduler midiOutputScheduler;
+	midiOutputSchedulerPtr = &midiOutputScheduler;
+	UsartMidiOutputQueue midiOutputQueue;
+	midiOutputQueuePtr = &midiOutputQueue;
+
 	// setup midi handler
 	MidiHandler midiHandler;
 	midiHandlerPtr = &midiHandler;
@@ -458,6 +508,7 @@ int main(void)
 	MnemonicAudioManager audioManager( sdCard, reinterpret_cast<uint8_t*>(D1_AXISRAM_BASE), 524288 );
 	audioManager.bindToMnemonicParameterEventSystem();
 	audioManager.bindToMidiEventSystem();
+	audioManager.setMidiSampleClock( &midiSampleClock );
 
 	// connect to audio buffer
 	AudioBuffer<int16_t, true> audioBuffer;
@@ -470,6 +521,11 @@ int main(void)
 	// enable instruction cache
 	SCB_EnableICache();
 
+#ifdef MNEMONIC_PROFILING
+	// the stats can be read with the debugger, see MnemonicProfiler
+	MnemonicProfiler::Enable( SYS_CLOCK_FREQUENCY );
+#endif
+
 	while ( true )
 	{
 		LLPD::adc_perform_conversion_sequence( EFFECT_ADC_NUM );
@@ -480,19 +536,15 @@ int main(void)
 
 		audioBuffer.pollToFillBuffers();
 
-		for ( const MidiEvent& midiEvent : audioManager.getMidiEventsToSendVec() )
+		// the dac timer releases the events to the midi output queue at the sample they're due, and the usart interrupt sends them
+		TimedMidiEvent timedMidiEvent;
+		while ( audioManager.getMidiEventsToSend().pop(timedMidiEvent) )
 		{
-			uint8_t* midiRawData = midiEvent.getRawData();
-
-			if ( midiEvent.getNumBytes() > 1 )
+			if ( timedMidiEvent.m_MidiEvent.getNumBytes() > 1 )
 			{
-				for ( unsigned int byteNum = 0; byteNum < midiEvent.getNumBytes(); byteNum++ )
-				{
-					LLPD::usart_transmit( MIDI_USART_NUM, midiRawData[byteNum] );
-				}
+				midiOutputScheduler.schedule( timedMidiEvent );
 			}
 		}
-		audioManager.getMidiEventsToSendVec().clear();
 
 		audioManager.publishUiEvents();
 	}
@@ -508,6 +560,9 @@ extern "C" void TIM6_DAC_IRQHandler (void)
 			uint16_t outValR = audioBufferPtr->getNextSampleR( 0 ) + ( 4096 / 2 );
 
 			LLPD::dac_send( outValL, outValR );
+
+			midiSampleClockPtr->tick();
+			midiOutputSchedulerPtr->release( midiSampleClockPtr->getSampleCount(), *midiOutputQueuePtr );
 		}
 	}
 
@@ -525,9 +580,19 @@ extern "C" void USART2_IRQHandler (void) // logging usart
 
 extern "C" void USART6_IRQHandler (void) // midi usart
 {
-	uint16_t data = LLPD::usart_receive( MIDI_USART_NUM );
-	if ( midiHandlerPtr )
+	// the receive and transmit empty interrupts share this handler
+	if ( MIDI_USART->ISR & USART_ISR_RXNE_RXFNE )
+	{
+		uint16_t data = LLPD::usart_receive( MIDI_USART_NUM );
+		if ( midiHandlerPtr )
+		{
+			midiSampleClockPtr->onByteReceived( data );
+			midiHandlerPtr->processByte( data );
+		}
+	}
+
+	if ( (MIDI_USART->CR1 & USART_CR1_TXEIE_TXFNFIE) && (MIDI_USART->ISR & USART_ISR_TXE_TXFNF) && midiOutputQueuePtr )
 	{
-		midiHandlerPtr->processByte( data );
+		midiOutputQueuePtr->transmitNextByte();
 	}
 }